@@ -4,6 +4,7 @@
 #include "guis/GuiInfoPopup.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "utils/TraceUtil.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/gamelist/ISimpleGameListView.h"
 #include "views/ViewController.h"
@@ -135,6 +136,8 @@ bool CollectionSystemManager::saveCustomCollection(SystemData* sys)
 // loads all Collection Systems
 void CollectionSystemManager::loadCollectionSystems(bool async)
 {
+	TraceScope("CollectionSystemManager::loadCollectionSystems");
+
 	initAutoCollectionSystems();
 	CollectionSystemDecl decl = mCollectionSystemDeclsIndex[CUSTOM_COLL_ID];
 	mCustomCollectionsBundle = createNewCollectionEntry(decl.name, decl, CollectionFlags::NONE);
@@ -178,6 +181,20 @@ void CollectionSystemManager::updateSystemsList()
 {
 	// remove all Collection Systems
 	removeCollectionsFromDisplayedSystems();
+
+	// populate the enabled ones that aren't yet with one pass over all games, random comes last as it needs the others
+	std::vector<CollectionSystemData*> unpopulated;
+	for(auto it = mCustomCollectionSystemsData.begin(); it != mCustomCollectionSystemsData.end(); it++)
+	{
+		if (it->second.isEnabled && !it->second.isPopulated)
+			unpopulated.push_back(&(it->second));
+	}
+	for(auto it = mAutoCollectionSystemsData.begin(); it != mAutoCollectionSystemsData.end(); it++)
+	{
+		if (it->second.isEnabled && !it->second.isPopulated && it->second.decl.type != AUTO_RANDOM)
+			unpopulated.push_back(&(it->second));
+	}
+	populateCollections(unpopulated);
 	// add custom enabled ones
 	addEnabledCollectionsToDisplayedSystems(&mCustomCollectionSystemsData, false);
 
@@ -214,11 +231,14 @@ void CollectionSystemManager::updateSystemsList()
 	// finally, add random
 	addEnabledCollectionsToDisplayedSystems(&mAutoCollectionSystemsData, true);
 
-	// create views for collections, before reload
-	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
+	// create views for collections, before reload (unless views are only built once they are needed)
+	if(!Settings::getInstance()->getBool("LazyGamelistViews"))
 	{
-		if ((*sysIt)->isCollection())
-			ViewController::get()->getGameListView((*sysIt));
+		for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
+		{
+			if ((*sysIt)->isCollection())
+				ViewController::get()->getGameListView((*sysIt));
+		}
 	}
 
 	// if we were editing a custom collection, and it's no longer enabled, exit edit mode
@@ -245,75 +265,138 @@ void CollectionSystemManager::refreshCollectionSystems(FileData* file)
 	}
 }
 
+// same as above for a batch of files, every collection is only sorted and refreshed once
+void CollectionSystemManager::refreshCollectionSystems(const std::vector<FileData*>& files)
+{
+	std::map<std::string, CollectionSystemData> allCollections;
+	allCollections.insert(mAutoCollectionSystemsData.cbegin(), mAutoCollectionSystemsData.cend());
+	allCollections.insert(mCustomCollectionSystemsData.cbegin(), mCustomCollectionSystemsData.cend());
+
+	for(auto sysDataIt = allCollections.cbegin(); sysDataIt != allCollections.cend(); sysDataIt++)
+	{
+		if (!sysDataIt->second.isPopulated)
+			continue;
+
+		for(auto fileIt = files.cbegin(); fileIt != files.cend(); fileIt++)
+		{
+			if ((*fileIt)->getSystem()->isGameSystem() && (*fileIt)->getType() == GAME)
+				updateCollectionEntry(*fileIt, sysDataIt->second, false);
+		}
+
+		finishCollectionUpdate(sysDataIt->second);
+	}
+}
+
+// removes a game from a collection, through its gamelist view only if that was built already
+static void removeCollectionEntry(SystemData* viewSystem, FileData* entry, bool refreshView)
+{
+	if (ViewController::get()->hasGameListView(viewSystem))
+		ViewController::get()->getGameListView(viewSystem).get()->remove(entry, false, refreshView);
+	else
+		delete entry; // takes it out of its folder and the filter index
+}
+
 void CollectionSystemManager::updateCollectionSystem(FileData* file, CollectionSystemData sysData)
 {
 	if (sysData.isPopulated)
 	{
-		// collection files use the full path as key, to avoid clashes
-		std::string key = file->getFullPath();
-
-		SystemData* curSys = sysData.system;
-		const std::unordered_map<std::string, FileData*>& children = curSys->getRootFolder()->getChildrenByFilename();
-		bool found = children.find(key) != children.cend();
-		FileData* rootFolder = curSys->getRootFolder();
-		FileFilterIndex* fileIndex = curSys->getIndex();
-		std::string name = curSys->getName();
-
-		if (found) {
-			// if we found it, we need to update it
-			FileData* collectionEntry = children.at(key);
-			// remove from index, so we can re-index metadata after refreshing
-			fileIndex->removeFromIndex(collectionEntry);
-			collectionEntry->refreshMetadata();
-			// found and we are removing
-			if (name == "favorites" && file->metadata.get("favorite") == "false") {
-				// need to check if still marked as favorite, if not remove
-				ViewController::get()->getGameListView(curSys).get()->remove(collectionEntry, false, true);
-			}
-			else
-			{
-				// re-index with new metadata
-				fileIndex->addToIndex(collectionEntry);
-				ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
-			}
+		updateCollectionEntry(file, sysData, true);
+		finishCollectionUpdate(sysData);
+	}
+}
+
+void CollectionSystemManager::updateCollectionEntry(FileData* file, const CollectionSystemData& sysData, bool refreshViews)
+{
+	// collection files use the full path as key, to avoid clashes
+	std::string key = file->getFullPath();
+
+	SystemData* curSys = sysData.system;
+	const std::unordered_map<std::string, FileData*>& children = curSys->getRootFolder()->getChildrenByFilename();
+	bool found = children.find(key) != children.cend();
+	FileData* rootFolder = curSys->getRootFolder();
+	FileFilterIndex* fileIndex = curSys->getIndex();
+	std::string name = curSys->getName();
+
+	if (found) {
+		// if we found it, we need to update it
+		FileData* collectionEntry = children.at(key);
+		// remove from index, so we can re-index metadata after refreshing
+		fileIndex->removeFromIndex(collectionEntry);
+		collectionEntry->refreshMetadata();
+		// found and we are removing
+		if (name == "favorites" && file->metadata.get(META_FAVORITE) == "false") {
+			// need to check if still marked as favorite, if not remove
+			removeCollectionEntry(curSys, collectionEntry, refreshViews);
 		}
 		else
 		{
-			// we didn't find it here - we need to check if we should add it
-			if (name == "recent" && file->metadata.get("playcount") > "0" && includeFileInAutoCollections(file) ||
-				name == "favorites" && file->metadata.get("favorite") == "true") {
-				CollectionFileData* newGame = new CollectionFileData(file, curSys);
-				rootFolder->addChild(newGame);
-				fileIndex->addToIndex(newGame);
+			// re-index with new metadata
+			fileIndex->addToIndex(collectionEntry);
+			if (refreshViews)
+				ViewController::get()->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
+		}
+	}
+	else
+	{
+		// we didn't find it here - we need to check if we should add it
+		if (name == "recent" && file->metadata.getInt(META_PLAYCOUNT) > 0 && includeFileInAutoCollections(file) ||
+			name == "favorites" && file->metadata.get(META_FAVORITE) == "true" ||
+			name == "all" && sysData.decl.type == AUTO_ALL_GAMES && includeFileInAutoCollections(file)) {
+			CollectionFileData* newGame = new (curSys->getArena()) CollectionFileData(file, curSys);
+			rootFolder->addChild(newGame);
+			fileIndex->addToIndex(newGame);
+			if (refreshViews)
+			{
 				ViewController::get()->onFileChanged(file, FILE_METADATA_CHANGED);
-				ViewController::get()->getGameListView(curSys)->onFileChanged(newGame, FILE_METADATA_CHANGED);
+				// a view that wasn't built yet shows the new game once it is
+				if (ViewController::get()->hasGameListView(curSys))
+					ViewController::get()->getGameListView(curSys)->onFileChanged(newGame, FILE_METADATA_CHANGED);
 			}
 		}
-		rootFolder->sort(getSortTypeFromString(mCollectionSystemDeclsIndex[name].defaultSort));
-		if (name == "recent")
-		{
-			trimCollectionCount(rootFolder, LAST_PLAYED_MAX, false);
-			ViewController::get()->onFileChanged(rootFolder, FILE_METADATA_CHANGED);
-			// Force re-calculation of cursor position
+	}
+}
+
+void CollectionSystemManager::finishCollectionUpdate(const CollectionSystemData& sysData)
+{
+	SystemData* curSys = sysData.system;
+	FileData* rootFolder = curSys->getRootFolder();
+	std::string name = curSys->getName();
+
+	rootFolder->sort(getSortTypeFromString(mCollectionSystemDeclsIndex[name].defaultSort));
+	if (name == "recent")
+	{
+		trimCollectionCount(rootFolder, LAST_PLAYED_MAX, false);
+		ViewController::get()->onFileChanged(rootFolder, FILE_METADATA_CHANGED);
+		// Force re-calculation of cursor position
+		if (ViewController::get()->hasGameListView(curSys))
 			ViewController::get()->getGameListView(curSys)->setViewportTop(TextListComponent<FileData>::REFRESH_LIST_CURSOR_POS);
-		}
-		else
-			ViewController::get()->onFileChanged(rootFolder, FILE_SORTED);
 	}
+	else
+		ViewController::get()->onFileChanged(rootFolder, FILE_SORTED);
 }
 
 void CollectionSystemManager::trimCollectionCount(FileData* rootFolder, int limit, bool shuffle)
 {
 	SystemData* curSys = rootFolder->getSystem();
-	while ((int)rootFolder->getChildrenListToDisplay().size() > limit)
-	{
-		std::vector<FileData*> games = rootFolder->getFilesRecursive(GAME, true);
-		if (shuffle)
-			std::shuffle(games.begin(), games.end(), SystemData::sURNG);
 
-		CollectionFileData* gameToRemove = (CollectionFileData*)games.back();
-		ViewController::get()->getGameListView(curSys).get()->remove(gameToRemove, false, false);
+	// the displayed games are only collected once, in display order, and the excess is removed in one go:
+	// the tail of the sorted list (the least recently played ones for "recent"), or a random sample
+	std::vector<FileData*> games = rootFolder->getFilesRecursive(GAME, true);
+	const int excess = Math::max((int)games.size() - limit, 0);
+
+	if (shuffle)
+	{
+		// partial Fisher-Yates, picks excess games uniformly at random and moves them to the end
+		for (int i = 0; i < excess; i++)
+		{
+			std::uniform_int_distribution<int> pick(0, (int)games.size() - 1 - i);
+			std::swap(games[pick(SystemData::sURNG)], games[games.size() - 1 - i]);
+		}
 	}
+
+	for (auto it = games.cend() - excess; it != games.cend(); it++)
+		removeCollectionEntry(curSys, *it, false);
+
 	ViewController::get()->onFileChanged(rootFolder, FILE_REMOVED);
 }
 
@@ -338,7 +421,7 @@ void CollectionSystemManager::deleteCollectionFiles(FileData* file)
 				sysDataIt->second.needsSave = true;
 				FileData* collectionEntry = children.at(key);
 				SystemData* systemViewToUpdate = getSystemToView(sysDataIt->second.system);
-				ViewController::get()->getGameListView(systemViewToUpdate).get()->remove(collectionEntry, false, true);
+				removeCollectionEntry(systemViewToUpdate, collectionEntry, true);
 			}
 		}
 	}
@@ -532,7 +615,7 @@ bool CollectionSystemManager::toggleGameInCollection(FileData* file)
 			else
 			{
 				// we didn't find it here, we should add it
-				CollectionFileData* newGame = new CollectionFileData(file, sysData);
+				CollectionFileData* newGame = new (sysData->getArena()) CollectionFileData(file, sysData);
 				rootFolder->addChild(newGame);
 				fileIndex->addToIndex(newGame);
 				// this is the biggest performance bottleneck for this process.
@@ -700,11 +783,11 @@ void CollectionSystemManager::updateCollectionFolderMetadata(SystemData* sys)
 			games_counter++;
 			FileData* file = iter->second;
 
-			std::string new_rating = file->metadata.get("rating");
-			std::string new_releasedate = file->metadata.get("releasedate");
-			std::string new_developer = file->metadata.get("developer");
-			std::string new_genre = file->metadata.get("genre");
-			std::string new_players = file->metadata.get("players");
+			std::string new_rating = file->metadata.get(META_RATING);
+			std::string new_releasedate = file->metadata.get(META_RELEASEDATE);
+			std::string new_developer = file->metadata.get(META_DEVELOPER);
+			std::string new_genre = file->metadata.get(META_GENRE);
+			std::string new_players = file->metadata.get(META_PLAYERS);
 
 			rating = (new_rating > rating ? (new_rating != "" ? new_rating : rating) : rating);
 			players = (new_players > players ? (new_players != "" ? new_players : players) : players);
@@ -736,15 +819,15 @@ void CollectionSystemManager::updateCollectionFolderMetadata(SystemData* sys)
 	}
 
 
-	rootFolder->metadata.set("desc", desc);
-	rootFolder->metadata.set("rating", rating);
-	rootFolder->metadata.set("players", players);
-	rootFolder->metadata.set("genre", genre);
-	rootFolder->metadata.set("releasedate", releasedate);
-	rootFolder->metadata.set("developer", developer);
-	rootFolder->metadata.set("video", video);
-	rootFolder->metadata.set("thumbnail", thumbnail);
-	rootFolder->metadata.set("image", image);
+	rootFolder->metadata.set(META_DESC, desc);
+	rootFolder->metadata.set(META_RATING, rating);
+	rootFolder->metadata.set(META_PLAYERS, players);
+	rootFolder->metadata.set(META_GENRE, genre);
+	rootFolder->metadata.set(META_RELEASEDATE, releasedate);
+	rootFolder->metadata.set(META_DEVELOPER, developer);
+	rootFolder->metadata.set(META_VIDEO, video);
+	rootFolder->metadata.set(META_THUMBNAIL, thumbnail);
+	rootFolder->metadata.set(META_IMAGE, image);
 }
 
 void CollectionSystemManager::initCustomCollectionSystems()
@@ -824,7 +907,8 @@ void CollectionSystemManager::addRandomGames(SystemData* newSys, SystemData* sou
 	}
 
 	// load exclusion collection
-	std::unordered_map<std::string,FileData*> exclusionMap;
+	static const std::unordered_map<std::string,FileData*> noExclusions;
+	const std::unordered_map<std::string,FileData*>* exclusions = &noExclusions;
 	std::string exclusionCollection = Settings::getInstance()->getString("RandomCollectionExclusionCollection");
 	auto sysDataIt = mCustomCollectionSystemsData.find(exclusionCollection);
 
@@ -834,14 +918,15 @@ void CollectionSystemManager::addRandomGames(SystemData* newSys, SystemData* sou
 			populateCustomCollection(&(sysDataIt->second));
 		}
 
-		exclusionMap = mCustomCollectionSystemsData[exclusionCollection].system->getRootFolder()->getChildrenByFilename();
+		exclusions = &sysDataIt->second.system->getRootFolder()->getChildrenByFilename();
 
 	}
+	const std::unordered_map<std::string,FileData*>& exclusionMap = *exclusions;
 
 	// we do this to avoid trying to add more games than there are in the system
-	gamesForSourceSystem = Math::min(gamesForSourceSystem, sourceSystem->getRootFolder()->getFilesRecursive(GAME).size());
+	gamesForSourceSystem = Math::min(gamesForSourceSystem, (int)sourceSystem->getRootFolder()->getGameCount());
 
-	int startCount = rootFolder->getFilesRecursive(GAME).size();
+	int startCount = rootFolder->getGameCount();
 	int endCount = startCount + gamesForSourceSystem;
 	int retryCount = 10;
 
@@ -853,12 +938,12 @@ void CollectionSystemManager::addRandomGames(SystemData* newSys, SystemData* sou
 		if(exclusionMap.find(randomGame->getFullPath()) == exclusionMap.end())
 		{
 			// Not in the exclusion collection
-			newGame = new CollectionFileData(randomGame, newSys);
+			newGame = new (newSys->getArena()) CollectionFileData(randomGame, newSys);
 			rootFolder->addChild(newGame);
 			index->addToIndex(newGame);
 		}
 
-		if (rootFolder->getFilesRecursive(GAME).size() > iterCount)
+		if (rootFolder->getGameCount() > iterCount)
 		{
 			// added game, proceed
 			iterCount++;
@@ -884,163 +969,232 @@ void CollectionSystemManager::populateRandomCollectionFromCollections(std::map<s
 {
 	CollectionSystemData* sysData = &mAutoCollectionSystemsData[RANDOM_COLL_ID];
 	SystemData* newSys = sysData->system;
-	CollectionSystemDecl sysDecl = sysData->decl;
 	FileData* rootFolder = newSys->getRootFolder();
 	FileFilterIndex* index = newSys->getIndex();
 
-	// iterate the auto collections map
+	// collections might not be populated, the missing ones are populated together
+	// we can't add games from the random collection to the random collection
+	std::vector<CollectionSystemData*> sources;
+	std::vector<CollectionSystemData*> unpopulated;
 	for(auto &c : mAutoCollectionSystemsData)
 	{
-		CollectionSystemData csd = c.second;
-		// we can't add games from the random collection to the random collection
-		if (csd.decl.type != AUTO_RANDOM)
-		{
-			// collections might not be populated
-			if (!csd.isPopulated)
-				populateAutoCollection(&csd);
-
-			if (csd.isPopulated)
-				addRandomGames(newSys, csd.system, rootFolder, index, mapsForRandomColl, DEFAULT_RANDOM_COLLECTIONS_GAMES);
-		}
+		if (c.second.decl.type != AUTO_RANDOM)
+			sources.push_back(&c.second);
 	}
-
-	// iterate the custom collections map
 	for(auto &c : mCustomCollectionSystemsData)
+		sources.push_back(&c.second);
+
+	for (auto it = sources.cbegin(); it != sources.cend(); it++)
 	{
-		CollectionSystemData csd = c.second;
-		// collections might not be populated
-		if (!csd.isPopulated)
-			populateCustomCollection(&csd);
+		if (!(*it)->isPopulated)
+			unpopulated.push_back(*it);
+	}
+	populateCollections(unpopulated);
 
-		if (csd.isPopulated)
-			addRandomGames(newSys, csd.system, rootFolder, index, mapsForRandomColl, DEFAULT_RANDOM_COLLECTIONS_GAMES);
+	for (auto it = sources.cbegin(); it != sources.cend(); it++)
+	{
+		if ((*it)->isPopulated)
+			addRandomGames(newSys, (*it)->system, rootFolder, index, mapsForRandomColl, DEFAULT_RANDOM_COLLECTIONS_GAMES);
 	}
 }
 
 // populates an Automatic Collection System
 void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysData)
 {
+	if (sysData->decl.type != AUTO_RANDOM)
+	{
+		populateCollections(std::vector<CollectionSystemData*>(1, sysData));
+		return;
+	}
+
 	SystemData* newSys = sysData->system;
 	CollectionSystemDecl sysDecl = sysData->decl;
 	FileData* rootFolder = newSys->getRootFolder();
 	FileFilterIndex* index = newSys->getIndex();
 
+	// user may have defined a custom collection with the same name as a system name, thus keeping maps in another map
 	std::map<std::string, std::map<std::string, int>> mapsForRandomColl;
-	if (sysDecl.type == AUTO_RANDOM)
+	std::map<std::string, int> randomSystems = Settings::getInstance()->getMap("RandomCollectionSystems");
+	mapsForRandomColl["RandomCollectionSystems"] = randomSystems;
+	std::map<std::string, int> randomAutoColl = Settings::getInstance()->getMap("RandomCollectionSystemsAuto");
+	mapsForRandomColl["RandomCollectionSystemsAuto"] = randomAutoColl;
+	std::map<std::string, int> randomCustColl = Settings::getInstance()->getMap("RandomCollectionSystemsCustom");
+	mapsForRandomColl["RandomCollectionSystemsCustom"] = randomCustColl;
+
+	// Only iterate through game systems, not collections yet
+	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
+	{
+		// we won't iterate all collections
+		if ((*sysIt)->isGameSystem() && !(*sysIt)->isCollection())
+			addRandomGames(newSys, *sysIt, rootFolder, index, mapsForRandomColl, DEFAULT_RANDOM_SYSTEM_GAMES);
+	}
+
+	// here we finish populating the Random collection based on other Collections
+	populateRandomCollectionFromCollections(mapsForRandomColl);
+
+	finishAutoCollection(sysData);
+}
+
+// populates a Custom Collection System
+void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData)
+{
+	populateCollections(std::vector<CollectionSystemData*>(1, sysData));
+}
+
+// populates any number of Automatic (except Random) and Custom Collection Systems in a single pass over all games
+void CollectionSystemManager::populateCollections(const std::vector<CollectionSystemData*>& collections)
+{
+	TraceScope("CollectionSystemManager::populateCollections");
+
+	struct CustomEntry
+	{
+		std::vector<CollectionSystemData*> collections;
+		bool found;
+	};
+
+	std::vector<CollectionSystemData*> autoCollections;
+	std::vector<CollectionSystemData*> customCollections;
+	// the games listed in the config files of the custom collections, by path
+	std::unordered_map<std::string, CustomEntry> customEntries;
+
+	for (auto it = collections.cbegin(); it != collections.cend(); it++)
 	{
-		// user may have defined a custom collection with the same name as a system name, thus keeping maps in another map
-		std::map<std::string, int> randomSystems = Settings::getInstance()->getMap("RandomCollectionSystems");
-		mapsForRandomColl["RandomCollectionSystems"] = randomSystems;
-		std::map<std::string, int> randomAutoColl = Settings::getInstance()->getMap("RandomCollectionSystemsAuto");
-		mapsForRandomColl["RandomCollectionSystemsAuto"] = randomAutoColl;
-		std::map<std::string, int> randomCustColl = Settings::getInstance()->getMap("RandomCollectionSystemsCustom");
-		mapsForRandomColl["RandomCollectionSystemsCustom"] = randomCustColl;
+		CollectionSystemData* sysData = *it;
+		if (!sysData->decl.isCustom)
+		{
+			if (sysData->decl.type != AUTO_RANDOM)
+				autoCollections.push_back(sysData);
+			continue;
+		}
+
+		std::string path = getCustomCollectionConfigPath(sysData->system->getName());
+		if(!Utils::FileSystem::exists(path))
+		{
+			LOG(LogInfo) << "Couldn't find custom collection config file at " << path;
+			continue;
+		}
+		LOG(LogInfo) << "Loading custom collection config file at " << path;
+
+		// get Configuration for this Custom System
+		std::ifstream input(path);
+		for(std::string gameKey; getline(input, gameKey); )
+		{
+			CustomEntry& entry = customEntries[gameKey];
+			entry.collections.push_back(sysData);
+			entry.found = false;
+		}
+		customCollections.push_back(sysData);
 	}
+
+	if (autoCollections.empty() && customCollections.empty())
+		return;
+
 	// Only iterate through game systems, not collections yet
 	for(auto sysIt = SystemData::sSystemVector.cbegin(); sysIt != SystemData::sSystemVector.cend(); sysIt++)
 	{
 		// we won't iterate all collections
-		if ((*sysIt)->isGameSystem() && !(*sysIt)->isCollection())
+		if (!(*sysIt)->isGameSystem() || (*sysIt)->isCollection())
+			continue;
+
+		(*sysIt)->getRootFolder()->visitFiles(GAME, [this, &autoCollections, &customEntries](FileData* game) -> bool
 		{
-			if (sysDecl.type == AUTO_RANDOM)
+			const bool includeInAuto = includeFileInAutoCollections(game);
+			// the key of the game in every collection, built once instead of by every lookup
+			const std::string path = game->getPath();
+
+			for (auto it = autoCollections.cbegin(); it != autoCollections.cend(); it++)
 			{
-				addRandomGames(newSys, *sysIt, rootFolder, index, mapsForRandomColl, DEFAULT_RANDOM_SYSTEM_GAMES);
+				bool include = includeInAuto;
+				switch((*it)->decl.type) {
+					case AUTO_LAST_PLAYED:
+						include = include && game->metadata.getInt(META_PLAYCOUNT) > 0;
+						break;
+					case AUTO_FAVORITES:
+						// we may still want to add files we don't want in auto collections in "favorites"
+						include = game->metadata.get(META_FAVORITE) == "true";
+						break;
+					case AUTO_ALL_GAMES:
+						break;
+					default:
+						// No-op to prevent compiler warnings
+						// Getting here means that the file is not part of a pre-defined collection.
+						include = false;
+						break;
+				}
+
+				if (include)
+					addToCollection(*it, game, path);
 			}
-			else
-			{
-				std::vector<FileData*> files = (*sysIt)->getRootFolder()->getFilesRecursive(GAME);
 
-				for(auto gameIt = files.cbegin(); gameIt != files.cend(); gameIt++)
+			// custom collections hold what "all games" would
+			if (includeInAuto && !customEntries.empty())
+			{
+				auto entry = customEntries.find(path);
+				if (entry != customEntries.end())
 				{
-					bool include = includeFileInAutoCollections(*gameIt);
-					switch(sysDecl.type) {
-						case AUTO_LAST_PLAYED:
-							include = include && (*gameIt)->metadata.get("playcount") > "0";
-							break;
-						case AUTO_FAVORITES:
-							// we may still want to add files we don't want in auto collections in "favorites"
-							include = (*gameIt)->metadata.get("favorite") == "true";
-							break;
-						case AUTO_ALL_GAMES:
-							break;
-						default:
-							// No-op to prevent compiler warnings
-							// Getting here means that the file is not part of a pre-defined collection.
-							include = false;
-							break;
-					}
-
-					if (include)
-					{
-						CollectionFileData* newGame = new CollectionFileData(*gameIt, newSys);
-						rootFolder->addChild(newGame);
-						index->addToIndex(newGame);
-					}
+					entry->second.found = true;
+					for (auto it = entry->second.collections.cbegin(); it != entry->second.collections.cend(); it++)
+						addToCollection(*it, game, path);
 				}
 			}
-		}
+			return true;
+		});
 	}
 
-	// here we finish populating the Random collection based on other Collections
-	if (sysDecl.type == AUTO_RANDOM)
-		populateRandomCollectionFromCollections(mapsForRandomColl);
+	for (auto entry = customEntries.cbegin(); entry != customEntries.cend(); entry++)
+	{
+		if (entry->second.found)
+			continue;
 
-	// sort before optional trimming, if collection is displayed
-	if (sysData->isEnabled)
-		rootFolder->sort(getSortTypeFromString(sysDecl.defaultSort));
+		for (auto it = entry->second.collections.cbegin(); it != entry->second.collections.cend(); it++)
+			LOG(LogInfo) << "Couldn't find game referenced at '" << entry->first << "' for system config '" << getCustomCollectionConfigPath((*it)->system->getName()) << "'";
+	}
 
-	if (sysData->isEnabled && (sysDecl.type == AUTO_LAST_PLAYED || sysDecl.type == AUTO_RANDOM))
+	for (auto it = autoCollections.cbegin(); it != autoCollections.cend(); it++)
+		finishAutoCollection(*it);
+
+	for (auto it = customCollections.cbegin(); it != customCollections.cend(); it++)
 	{
-		int trimValue = LAST_PLAYED_MAX;
-		if (sysDecl.type == AUTO_RANDOM)
-			trimValue = Settings::getInstance()->getInt("RandomCollectionMaxGames");
-		if (trimValue > 0)
-			trimCollectionCount(rootFolder, trimValue, sysDecl.type == AUTO_RANDOM);
+		SystemData* newSys = (*it)->system;
+		newSys->getRootFolder()->sort(getSortTypeFromString((*it)->decl.defaultSort));
+		updateCollectionFolderMetadata(newSys);
+		(*it)->isPopulated = true;
 	}
-
-	sysData->isPopulated = true;
 }
 
-// populates a Custom Collection System
-void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData)
+void CollectionSystemManager::addToCollection(CollectionSystemData* sysData, FileData* game, const std::string& path)
 {
 	SystemData* newSys = sysData->system;
-	CollectionSystemDecl sysDecl = sysData->decl;
-	std::string path = getCustomCollectionConfigPath(newSys->getName());
+	FileData* rootFolder = newSys->getRootFolder();
 
-	if(!Utils::FileSystem::exists(path))
-	{
-		LOG(LogInfo) << "Couldn't find custom collection config file at " << path;
+	// the same file may be part of more than one system
+	if (rootFolder->getChildrenByFilename().find(path) != rootFolder->getChildrenByFilename().cend())
 		return;
-	}
-	LOG(LogInfo) << "Loading custom collection config file at " << path;
 
-	FileData* rootFolder = newSys->getRootFolder();
-	FileFilterIndex* index = newSys->getIndex();
+	CollectionFileData* newGame = new (newSys->getArena()) CollectionFileData(game, newSys);
+	rootFolder->addChild(newGame);
+	newSys->getIndex()->addToIndex(newGame);
+}
 
-	// get Configuration for this Custom System
-	std::ifstream input(path);
+// sorts and, for the bounded ones, trims a freshly populated Automatic Collection System
+void CollectionSystemManager::finishAutoCollection(CollectionSystemData* sysData)
+{
+	CollectionSystemDecl& sysDecl = sysData->decl;
+	FileData* rootFolder = sysData->system->getRootFolder();
 
-	// get all files map
-	std::unordered_map<std::string,FileData*> allFilesMap = getAllGamesCollection()->getRootFolder()->getChildrenByFilename();
+	// sort before optional trimming, if collection is displayed
+	if (sysData->isEnabled)
+		rootFolder->sort(getSortTypeFromString(sysDecl.defaultSort));
 
-	// iterate list of files in config file
-	for(std::string gameKey; getline(input, gameKey); )
+	if (sysData->isEnabled && (sysDecl.type == AUTO_LAST_PLAYED || sysDecl.type == AUTO_RANDOM))
 	{
-		std::unordered_map<std::string,FileData*>::const_iterator it = allFilesMap.find(gameKey);
-		if (it != allFilesMap.cend())
-		{
-			CollectionFileData* newGame = new CollectionFileData(it->second, newSys);
-			rootFolder->addChild(newGame);
-			index->addToIndex(newGame);
-		}
-		else
-		{
-			LOG(LogInfo) << "Couldn't find game referenced at '" << gameKey << "' for system config '" << path << "'";
-		}
+		int trimValue = LAST_PLAYED_MAX;
+		if (sysDecl.type == AUTO_RANDOM)
+			trimValue = Settings::getInstance()->getInt("RandomCollectionMaxGames");
+		if (trimValue > 0)
+			trimCollectionCount(rootFolder, trimValue, sysDecl.type == AUTO_RANDOM);
 	}
-	rootFolder->sort(getSortTypeFromString(sysDecl.defaultSort));
-	updateCollectionFolderMetadata(newSys);
+
 	sysData->isPopulated = true;
 }
 
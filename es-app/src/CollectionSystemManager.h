@@ -83,6 +83,7 @@ public:
 	void updateSystemsList();
 
 	void refreshCollectionSystems(FileData* file);
+	void refreshCollectionSystems(const std::vector<FileData*>& files);
 	void updateCollectionSystem(FileData* file, CollectionSystemData sysData);
 	void deleteCollectionFiles(FileData* file);
 	void recreateCollection(SystemData* sysData);
@@ -126,8 +127,13 @@ private:
 	void initAutoCollectionSystems();
 	void initCustomCollectionSystems();
 	SystemData* createNewCollectionEntry(std::string name, CollectionSystemDecl sysDecl, const CollectionFlags flags);
+	void updateCollectionEntry(FileData* file, const CollectionSystemData& sysData, bool refreshViews);
+	void finishCollectionUpdate(const CollectionSystemData& sysData);
 	void populateAutoCollection(CollectionSystemData* sysData);
 	void populateCustomCollection(CollectionSystemData* sysData);
+	void populateCollections(const std::vector<CollectionSystemData*>& collections);
+	void addToCollection(CollectionSystemData* sysData, FileData* game, const std::string& path);
+	void finishAutoCollection(CollectionSystemData* sysData);
 	void addRandomGames(SystemData* newSys, SystemData* sourceSystem, FileData* rootFolder, FileFilterIndex* index,
 		std::map<std::string, std::map<std::string, int>> mapsForRandomColl, int defaultValue);
 	void populateRandomCollectionFromCollections(std::map<std::string, std::map<std::string, int>> mapsForRandomColl);
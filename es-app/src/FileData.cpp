@@ -1,12 +1,14 @@
 #include "FileData.h"
 
 #include "utils/FileSystemUtil.h"
+#include "utils/StringPoolUtil.h"
 #include "utils/StringUtil.h"
 #include "utils/TimeUtil.h"
 #include "AudioManager.h"
 #include "CollectionSystemManager.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
+#include "GameSearchIndex.h"
 #include "InputManager.h"
 #include "Log.h"
 #include "MameNames.h"
@@ -16,14 +18,21 @@
 #include "VolumeControl.h"
 #include "Window.h"
 #include <assert.h>
+#include <unordered_set>
+
+static const std::string noSortDescription;
 
 FileData::FileData(FileType type, const std::string& path, SystemEnvironmentData* envData, SystemData* system)
-	: mType(type), mPath(path), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: mType(type), mSystem(system), mEnvData(envData), mSourceFileData(NULL), mParent(NULL), mSortDesc(&noSortDescription), mGameCount(type == GAME ? 1 : 0), mDisplayedGameCount(mGameCount), metadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
+	const size_t nameStart = path.find_last_of('/') + 1;
+	mDirectory = &Utils::StringPool::intern(path.substr(0, nameStart));
+	mFileName  = path.substr(nameStart);
+
 	// metadata needs at least a name field (since that's what getName() will return)
-	if(metadata.get("name").empty())
-		metadata.set("name", getDisplayName());
-	mSystemName = system->getName();
+	if(metadata.get(META_NAME).empty())
+		metadata.set(META_NAME, getDisplayName());
+	mSystemName = &Utils::StringPool::intern(system->getName());
 	metadata.resetChangedFlag();
 }
 
@@ -32,15 +41,79 @@ FileData::~FileData()
 	if(mParent)
 		mParent->removeChild(this);
 
-	if(mType == GAME)
+	// the index is already gone when the whole system is deleted
+	if(mType == GAME && mSystem->getIndex())
 		mSystem->getIndex()->removeFromIndex(this);
 
+	if(mType == GAME)
+		GameSearchIndex::onGameRemoved(this);
+
+	mChildren.clear();
+}
+
+// every node is prefixed with the arena it came from (NULL for the heap), so delete can hand it back to the right place
+static const size_t NODE_HEADER_SIZE = 16;
+static_assert(NODE_HEADER_SIZE >= sizeof(Utils::Arena*), "node header too small");
+
+static inline Utils::Arena*& nodeArena(void* ptr)
+{
+	return *(Utils::Arena**)((char*)ptr - NODE_HEADER_SIZE);
+}
+
+void* FileData::operator new(size_t size)
+{
+	char* ptr = (char*)::operator new(NODE_HEADER_SIZE + size) + NODE_HEADER_SIZE;
+	nodeArena(ptr) = NULL;
+	return ptr;
+}
+
+void* FileData::operator new(size_t size, Utils::Arena& arena)
+{
+	char* ptr = (char*)arena.allocate(NODE_HEADER_SIZE + size) + NODE_HEADER_SIZE;
+	nodeArena(ptr) = &arena;
+	return ptr;
+}
+
+void FileData::operator delete(void* ptr, size_t size)
+{
+	if(!ptr)
+		return;
+
+	Utils::Arena* arena = nodeArena(ptr);
+	if(arena)
+		arena->deallocate((char*)ptr - NODE_HEADER_SIZE, NODE_HEADER_SIZE + size);
+	else
+		::operator delete((char*)ptr - NODE_HEADER_SIZE);
+}
+
+void FileData::operator delete(void* ptr, Utils::Arena& arena)
+{
+	// the size isn't known here, the slot is simply left to the arena
+}
+
+void FileData::deleteTree()
+{
+	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	{
+		(*it)->mParent = NULL;
+
+		// i.e. the root folders of custom collections in their bundle, those go with their own system
+		if((*it)->mSystem == mSystem)
+			(*it)->deleteTree();
+	}
 	mChildren.clear();
+	mChildrenByFilename.clear();
+
+	// arena memory is released with the arena itself, there's no point in putting every node on its free list
+	if(nodeArena(this))
+		this->~FileData();
+	else
+		delete this;
 }
 
 std::string FileData::getDisplayName() const
 {
-	std::string stem = Utils::FileSystem::getStem(mPath);
+	std::string stem = Utils::FileSystem::getStem(mFileName);
 	if(mSystem && (mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO)))
 		stem = MameNames::getInstance()->getRealName(stem);
 
@@ -54,12 +127,12 @@ std::string FileData::getCleanName() const
 
 const std::string FileData::getThumbnailPath() const
 {
-	std::string thumbnail = metadata.get("thumbnail");
+	std::string thumbnail = metadata.get(META_THUMBNAIL);
 
 	// no thumbnail, try image
 	if(thumbnail.empty())
 	{
-		thumbnail = metadata.get("image");
+		thumbnail = metadata.get(META_IMAGE);
 
 		// no image, try to use local image
 		if(thumbnail.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -82,15 +155,15 @@ const std::string FileData::getThumbnailPath() const
 
 const std::string& FileData::getName()
 {
-	return metadata.get("name");
+	return metadata.get(META_NAME);
 }
 
 const std::string& FileData::getSortName()
 {
-	if (metadata.get("sortname").empty())
-		return metadata.get("name");
+	if (metadata.get(META_SORTNAME).empty())
+		return metadata.get(META_NAME);
 	else
-		return metadata.get("sortname");
+		return metadata.get(META_SORTNAME);
 }
 
 const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
@@ -115,7 +188,7 @@ const std::vector<FileData*>& FileData::getChildrenListToDisplay() {
 
 const std::string FileData::getVideoPath() const
 {
-	std::string video = metadata.get("video");
+	std::string video = metadata.get(META_VIDEO);
 
 	// no video, try to use local video
 	if(video.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -130,7 +203,7 @@ const std::string FileData::getVideoPath() const
 
 const std::string FileData::getMarqueePath() const
 {
-	std::string marquee = metadata.get("marquee");
+	std::string marquee = metadata.get(META_MARQUEE);
 
 	// no marquee, try to use local marquee
 	if(marquee.empty() && Settings::getInstance()->getBool("LocalArt"))
@@ -152,7 +225,7 @@ const std::string FileData::getMarqueePath() const
 
 const std::string FileData::getImagePath() const
 {
-	std::string image = metadata.get("image");
+	std::string image = metadata.get(META_IMAGE);
 
 	// no image, try to use local image
 	if(image.empty())
@@ -175,33 +248,42 @@ const std::string FileData::getImagePath() const
 std::vector<FileData*> FileData::getFilesRecursive(unsigned int typeMask, bool displayedOnly) const
 {
 	std::vector<FileData*> out;
+	if(typeMask == GAME)
+		out.reserve(mGameCount);
+
+	visitFiles(typeMask, [&out](FileData* file) -> bool { out.push_back(file); return true; }, displayedOnly);
+	return out;
+}
+
+bool FileData::isDisplayed(FileData* file) const
+{
 	FileFilterIndex* idx = mSystem->getIndex();
+	return !idx->isFiltered() || idx->showFile(file);
+}
 
-	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+unsigned int FileData::countDisplayedGames()
+{
+	if(mType == GAME)
 	{
-		if((*it)->getType() & typeMask)
-		{
-			if (!displayedOnly || !idx->isFiltered() || idx->showFile(*it))
-				out.push_back(*it);
-		}
-
-		if((*it)->getChildren().size() > 0)
-		{
-			std::vector<FileData*> subchildren = (*it)->getFilesRecursive(typeMask, displayedOnly);
-			out.insert(out.cend(), subchildren.cbegin(), subchildren.cend());
-		}
+		FileFilterIndex* idx = mSystem->getIndex();
+		mDisplayedGameCount = (!idx->isFiltered() || idx->showFile(this)) ? 1 : 0;
+		return mDisplayedGameCount;
 	}
 
-	return out;
+	mDisplayedGameCount = 0;
+	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+		mDisplayedGameCount += (*it)->countDisplayedGames();
+
+	return mDisplayedGameCount;
 }
 
-std::string FileData::getKey() {
+const std::string& FileData::getKey() {
 	return getFileName();
 }
 
 const bool FileData::isArcadeAsset()
 {
-	const std::string stem = Utils::FileSystem::getStem(mPath);
+	const std::string stem = Utils::FileSystem::getStem(mFileName);
 	return (
 		(mSystem && (mSystem->hasPlatformId(PlatformIds::ARCADE) || mSystem->hasPlatformId(PlatformIds::NEOGEO)))
 		&&
@@ -225,6 +307,19 @@ void FileData::addChild(FileData* file)
 		mChildrenByFilename[key] = file;
 		mChildren.push_back(file);
 		file->mParent = this;
+
+		// placed the next time the folder is sorted by that order
+		for(auto it = mSortOrders.begin(); it != mSortOrders.end(); it++)
+		{
+			it->files.push_back(file);
+			it->stamps.push_back(0);
+		}
+
+		for(FileData* folder = this; folder != NULL; folder = folder->mParent)
+		{
+			folder->mGameCount += file->mGameCount;
+			folder->mDisplayedGameCount += file->mDisplayedGameCount;
+		}
 	}
 }
 
@@ -237,6 +332,16 @@ void FileData::removeChild(FileData* file)
 	{
 		if(*it == file)
 		{
+			for(FileData* folder = this; folder != NULL; folder = folder->mParent)
+			{
+				folder->mGameCount -= file->mGameCount;
+				folder->mDisplayedGameCount -= file->mDisplayedGameCount;
+			}
+
+			// taken out of the sort orders all at once the next time they are used
+			for(auto orderIt = mSortOrders.begin(); orderIt != mSortOrders.end(); orderIt++)
+				orderIt->removed = true;
+
 			file->mParent = NULL;
 			mChildren.erase(it);
 			return;
@@ -250,30 +355,126 @@ void FileData::removeChild(FileData* file)
 
 void FileData::sort(ComparisonFunction& comparator, bool ascending)
 {
-	if (ascending)
+	// the current order comes first, only the one used before it is kept besides it
+	static const size_t MAX_SORT_ORDERS = 2;
+
+	auto it = mSortOrders.begin();
+	while(it != mSortOrders.end() && !(it->comparator == &comparator && it->ascending == ascending))
+		it++;
+
+	if(it != mSortOrders.end())
 	{
-		std::stable_sort(mChildren.begin(), mChildren.end(), comparator);
-		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+		std::rotate(mSortOrders.begin(), it, it + 1);
+	}
+	else
+	{
+		// starts out from the current order, the first update then sorts it like a plain stable_sort would
+		mSortOrders.insert(mSortOrders.begin(), SortOrder());
+		SortOrder& order = mSortOrders.front();
+		order.comparator = &comparator;
+		order.ascending = ascending;
+		order.removed = false;
+		order.nameKeyGeneration = FileSorts::getNameKeyGeneration();
+		order.files = mChildren;
+		order.stamps.assign(mChildren.size(), 0);
+
+		if(mSortOrders.size() > MAX_SORT_ORDERS)
+			mSortOrders.resize(MAX_SORT_ORDERS);
+	}
+
+	SortOrder* order = &mSortOrders.front();
+	updateSortOrder(*order);
+	mChildren = order->files;
+
+	for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+	{
+		if((*it)->getChildren().size() > 0)
+			(*it)->sort(comparator, ascending);
+	}
+}
+
+void FileData::updateSortOrder(SortOrder& order)
+{
+	// up to this many changed files are moved into place one by one, more than that are sorted in with everything else
+	static const size_t MAX_MOVED_FILES = 32;
+
+	ComparisonFunction* comparator = order.comparator;
+	const bool ascending = order.ascending;
+	// sorting descending with the arguments swapped keeps equal files in the same order as ascending does
+	auto compare = [comparator, ascending](const FileData* a, const FileData* b) { return ascending ? comparator(a, b) : comparator(b, a); };
+
+	// changed leading article settings change every name key
+	const unsigned int nameKeyGeneration = FileSorts::getNameKeyGeneration();
+	const bool resort = (order.nameKeyGeneration != nameKeyGeneration);
+	order.nameKeyGeneration = nameKeyGeneration;
+
+	// drop the removed children by what is still a child, they may be deleted already and can't be looked at. A
+	// deleted child's memory may hold a new child now, which is then both in its old and at its added place
+	if(order.removed)
+	{
+		std::unordered_set<const FileData*> children(mChildren.cbegin(), mChildren.cend());
+		size_t kept = 0;
+		for(size_t i = 0; i < order.files.size(); i++)
 		{
-			if((*it)->getChildren().size() > 0)
-				(*it)->sort(comparator, ascending);
+			if(children.erase(order.files[i]))
+			{
+				order.files[kept] = order.files[i];
+				order.stamps[kept] = order.stamps[i];
+				kept++;
+			}
 		}
+
+		order.files.resize(kept);
+		order.stamps.resize(kept);
+		order.removed = false;
 	}
-	else
+
+	// take out everything that was added or changed since it was placed, the rest is still in order
+	std::vector<FileData*> moved;
+	size_t kept = 0;
+	for(size_t i = 0; i < order.files.size(); i++)
 	{
-		std::stable_sort(mChildren.rbegin(), mChildren.rend(), comparator);
-		for(auto it = mChildren.rbegin(); it != mChildren.rend(); it++)
+		FileData* file = order.files[i];
+		if(order.stamps[i] == file->metadata.getChangeStamp())
 		{
-			if((*it)->getChildren().size() > 0)
-				(*it)->sort(comparator, ascending);
+			order.files[kept] = file;
+			order.stamps[kept] = order.stamps[i];
+			kept++;
 		}
+		else
+			moved.push_back(file);
 	}
+
+	if(moved.empty() && !resort)
+		return;
+
+	order.files.resize(kept);
+	order.stamps.resize(kept);
+
+	if(!resort && moved.size() <= MAX_MOVED_FILES)
+	{
+		for(auto it = moved.cbegin(); it != moved.cend(); it++)
+		{
+			const size_t index = std::upper_bound(order.files.cbegin(), order.files.cend(), *it, compare) - order.files.cbegin();
+			order.files.insert(order.files.cbegin() + index, *it);
+			order.stamps.insert(order.stamps.cbegin() + index, (*it)->metadata.getChangeStamp());
+		}
+		return;
+	}
+
+	order.files.insert(order.files.cend(), moved.cbegin(), moved.cend());
+	std::stable_sort(order.files.begin(), order.files.end(), compare);
+
+	order.stamps.resize(order.files.size());
+	for(size_t i = 0; i < order.files.size(); i++)
+		order.stamps[i] = order.files[i]->metadata.getChangeStamp();
 }
 
 void FileData::sort(const SortType& type)
 {
+	FileSorts::updateNameKeySettings();
 	sort(*type.comparisonFunction, type.ascending);
-	mSortDesc = type.description;
+	mSortDesc = &Utils::StringPool::intern(type.description);
 }
 
 void FileData::launchGame(Window* window)
@@ -327,14 +528,14 @@ void FileData::launchGame(Window* window)
 
 	FileData* gameToUpdate = getSourceFileData();
 
-	int timesPlayed = gameToUpdate->metadata.getInt("playcount") + 1;
-	gameToUpdate->metadata.set("playcount", std::to_string(static_cast<long long>(timesPlayed)));
+	int timesPlayed = gameToUpdate->metadata.getInt(META_PLAYCOUNT) + 1;
+	gameToUpdate->metadata.set(META_PLAYCOUNT, std::to_string(static_cast<long long>(timesPlayed)));
 
 	//update last played time
-	gameToUpdate->metadata.set("lastplayed", Utils::Time::DateTime(Utils::Time::now()));
+	gameToUpdate->metadata.set(META_LASTPLAYED, Utils::Time::DateTime(Utils::Time::now()));
 	CollectionSystemManager::get()->refreshCollectionSystems(gameToUpdate);
 
-	gameToUpdate->mSystem->onMetaDataSavePoint();
+	gameToUpdate->mSystem->onPlayStatisticsChanged(gameToUpdate);
 }
 
 CollectionFileData::CollectionFileData(FileData* file, SystemData* system)
@@ -345,7 +546,8 @@ CollectionFileData::CollectionFileData(FileData* file, SystemData* system)
 	refreshMetadata();
 	mParent = NULL;
 	metadata = mSourceFileData->metadata;
-	mSystemName = mSourceFileData->getSystem()->getName();
+	mSystemName = &Utils::StringPool::intern(mSourceFileData->getSystem()->getName());
+	mKey = getPath();
 }
 
 CollectionFileData::~CollectionFileData()
@@ -356,8 +558,8 @@ CollectionFileData::~CollectionFileData()
 	mParent = NULL;
 }
 
-std::string CollectionFileData::getKey() {
-	return getFullPath();
+const std::string& CollectionFileData::getKey() {
+	return mKey;
 }
 
 FileData* CollectionFileData::getSourceFileData()
@@ -374,14 +576,14 @@ void CollectionFileData::refreshMetadata()
 const std::string& CollectionFileData::getName()
 {
 	if (mDirty) {
-		mCollectionFileName = Utils::String::removeParenthesis(mSourceFileData->metadata.get("name"));
+		mCollectionFileName = Utils::String::removeParenthesis(mSourceFileData->metadata.get(META_NAME));
 		mCollectionFileName += " [" + Utils::String::toUpper(mSourceFileData->getSystem()->getName()) + "]";
 		mDirty = false;
 	}
 
 	if (Settings::getInstance()->getBool("CollectionShowSystemInfo"))
 		return mCollectionFileName;
-	return mSourceFileData->metadata.get("name");
+	return mSourceFileData->metadata.get(META_NAME);
 }
 
 // returns Sort Type based on a string description
@@ -2,6 +2,7 @@
 #ifndef ES_APP_FILE_DATA_H
 #define ES_APP_FILE_DATA_H
 
+#include "utils/Arena.h"
 #include "utils/FileSystemUtil.h"
 #include "MetaData.h"
 #include <unordered_map>
@@ -36,10 +37,24 @@ public:
 	FileData(FileType type, const std::string& path, SystemEnvironmentData* envData, SystemData* system);
 	virtual ~FileData();
 
+	// Nodes of a system tree are allocated from the arena of their system (new (system->getArena()) FileData(...)),
+	// plain new is still fine for nodes that never end up in a tree, like placeholders.
+	static void* operator new   (size_t size);
+	static void* operator new   (size_t size, Utils::Arena& arena);
+	static void  operator delete(void* ptr, size_t size);
+	static void  operator delete(void* ptr, Utils::Arena& arena); // only used if the constructor throws
+
+	// Destroys this folder and everything below it in one go, nothing gets unlinked from its parent on the way.
+	// Only meant for the root folder of a system that is being deleted.
+	void deleteTree();
+
 	virtual const std::string& getName();
 	virtual const std::string& getSortName();
 	inline FileType getType() const { return mType; }
-	inline const std::string& getPath() const { return mPath; }
+	// joins the path into a new string, hot loops compare with hasPath() or look up by getDirectory() and getFileName()
+	inline std::string getPath() const { return *mDirectory + mFileName; }
+	inline const std::string& getDirectory() const { return *mDirectory; } // with its trailing '/'
+	inline bool hasPath(const std::string& path) const { return (path.size() == mDirectory->size() + mFileName.size()) && (path.compare(0, mDirectory->size(), *mDirectory) == 0) && (path.compare(mDirectory->size(), std::string::npos, mFileName) == 0); }
 	inline FileData* getParent() const { return mParent; }
 	inline const std::unordered_map<std::string, FileData*>& getChildrenByFilename() const { return mChildrenByFilename; }
 	inline const std::vector<FileData*>& getChildren() const { return mChildren; }
@@ -53,6 +68,27 @@ public:
 	const std::vector<FileData*>& getChildrenListToDisplay();
 	std::vector<FileData*> getFilesRecursive(unsigned int typeMask, bool displayedOnly = false) const;
 
+	// Walks the subtree depth first in child order, like getFilesRecursive() but without collecting anything.
+	// visitor(FileData*) is called for every node whose type is in typeMask and returns false to stop the walk,
+	// in which case visitFiles() returns false as well. The tree must not be changed from inside the visitor.
+	template<typename Visitor>
+	bool visitFiles(unsigned int typeMask, Visitor visitor, bool displayedOnly = false) const { return visitFilesRecursive(typeMask, displayedOnly, visitor); }
+
+	// The first node in visitFiles() order that predicate(FileData*) accepts, NULL if there is none.
+	template<typename Predicate>
+	FileData* findFile(unsigned int typeMask, Predicate predicate, bool displayedOnly = false) const
+	{
+		FileData* found = NULL;
+		visitFiles(typeMask, [&found, &predicate](FileData* file) -> bool { if(!predicate(file)) return true; found = file; return false; }, displayedOnly);
+		return found;
+	}
+
+	// Games in this subtree (1 or 0 for a game itself), kept up to date by addChild() and removeChild().
+	// The displayed count only holds for the filter state it was last counted for, see countDisplayedGames().
+	inline unsigned int getGameCount() const { return mGameCount; }
+	inline unsigned int getDisplayedGameCount() const { return mDisplayedGameCount; }
+	unsigned int countDisplayedGames();
+
 	void addChild(FileData* file); // Error if mType != FOLDER
 	void removeChild(FileData* file); //Error if mType != FOLDER
 
@@ -60,12 +96,12 @@ public:
 
 	virtual inline void refreshMetadata() { return; };
 
-	virtual std::string getKey();
+	virtual const std::string& getKey();
 	const bool isArcadeAsset();
 	inline std::string getFullPath() { return getPath(); };
-	inline std::string getFileName() { return Utils::FileSystem::getFileName(getPath()); };
+	inline const std::string& getFileName() const { return mFileName; };
 	virtual FileData* getSourceFileData();
-	inline std::string getSystemName() const { return mSystemName; };
+	inline const std::string& getSystemName() const { return *mSystemName; };
 
 	// Returns our best guess at the "real" name for this file (will attempt to perform MAME name translation)
 	std::string getDisplayName() const;
@@ -87,24 +123,59 @@ public:
 	};
 
 	void sort(const SortType& type);
-	std::string getSortDescription() { return mSortDesc; }
+	std::string getSortDescription() { return *mSortDesc; }
 	MetaDataList metadata;
 
 protected:
 	FileData* mSourceFileData;
 	FileData* mParent;
-	std::string mSystemName;
+	const std::string* mSystemName; // interned
 
 private:
+	// The children in one sort order. Kept for the current and the previous order of the folder and updated as
+	// children are added, removed or their metadata changes, so sorting by it again only moves what changed.
+	struct SortOrder
+	{
+		ComparisonFunction* comparator;
+		bool ascending;
+		bool removed; // children were removed since the last update, files may still hold them
+		unsigned int nameKeyGeneration;
+		std::vector<FileData*> files;
+		std::vector<unsigned int> stamps; // metadata change stamp of every file when it was placed, 0 if it wasn't yet
+	};
+
 	void sort(ComparisonFunction& comparator, bool ascending = true);
+	void updateSortOrder(SortOrder& order);
+	bool isDisplayed(FileData* file) const;
+
+	template<typename Visitor>
+	bool visitFilesRecursive(unsigned int typeMask, bool displayedOnly, Visitor& visitor) const
+	{
+		for(auto it = mChildren.cbegin(); it != mChildren.cend(); it++)
+		{
+			if(((*it)->getType() & typeMask) && (!displayedOnly || isDisplayed(*it)) && !visitor(*it))
+				return false;
+
+			if(!(*it)->mChildren.empty() && !(*it)->visitFilesRecursive(typeMask, displayedOnly, visitor))
+				return false;
+		}
+
+		return true;
+	}
+
 	FileType mType;
-	std::string mPath;
+	// the path is split so siblings share one interned copy of their directory (with its trailing '/')
+	const std::string* mDirectory;
+	std::string mFileName;
 	SystemEnvironmentData* mEnvData;
 	SystemData* mSystem;
 	std::unordered_map<std::string,FileData*> mChildrenByFilename;
 	std::vector<FileData*> mChildren;
 	std::vector<FileData*> mFilteredChildren;
-	std::string mSortDesc;
+	const std::string* mSortDesc; // interned
+	unsigned int mGameCount;
+	unsigned int mDisplayedGameCount;
+	std::vector<SortOrder> mSortOrders;
 };
 
 class CollectionFileData : public FileData
@@ -115,11 +186,13 @@ public:
 	const std::string& getName();
 	void refreshMetadata();
 	FileData* getSourceFileData();
-	std::string getKey();
+	const std::string& getKey();
 private:
 	// needs to be updated when metadata changes
 	std::string mCollectionFileName;
 	bool mDirty;
+	// the full path, kept as the key is looked up far more often than there are collection entries
+	std::string mKey;
 };
 
 FileData::SortType getSortTypeFromString(std::string desc);
@@ -10,7 +10,8 @@
 #define INCLUDE_UNKNOWN false;
 
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false)
+	: filterByFavorites(false), filterByGenre(false), filterByHidden(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false),
+	  mValueNames(1), mShownChangeCount(0), mSelectionChangeCount(0), mChangeCount(0)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = {
@@ -72,7 +73,10 @@ void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
 			}
 		}
 	}
+
+	mImportedIndexes.push_back(indexToImport);
 }
+
 void FileFilterIndex::resetIndex()
 {
 	clearAllFilters();
@@ -83,6 +87,28 @@ void FileFilterIndex::resetIndex()
 	clearIndex(favoritesIndexAllKeys);
 	clearIndex(hiddenIndexAllKeys);
 	clearIndex(kidGameIndexAllKeys);
+
+	mSlots.clear();
+	mSlotFiles.clear();
+	mSlotStamps.clear();
+	mFreeSlots.clear();
+	mImportedIndexes.clear();
+	for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+	{
+		mColumns[i].primary.clear();
+		mColumns[i].secondary.clear();
+	}
+	mChangeCount++;
+}
+
+const FilterDataDecl* FileFilterIndex::getFilterDataDecl(FilterIndexType type) const
+{
+	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
+	{
+		if ((*it).type == type)
+			return &(*it);
+	}
+	return NULL;
 }
 
 std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary)
@@ -92,12 +118,10 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 	{
 		case GENRE_FILTER:
 		{
-			key = Utils::String::toUpper(game->metadata.get("genre"));
+			key = Utils::String::toUpper(game->metadata.get(META_GENRE));
 			key = Utils::String::trim(key);
 			if (getSecondary && !key.empty()) {
-				std::istringstream f(key);
-				std::string newKey;
-				getline(f, newKey, '/');
+				const std::string newKey = key.substr(0, key.find('/'));
 				if (!newKey.empty() && newKey != key)
 				{
 					key = newKey;
@@ -114,18 +138,18 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 			if (getSecondary)
 				break;
 
-			key = game->metadata.get("players");
+			key = game->metadata.get(META_PLAYERS);
 			break;
 		}
 		case PUBDEV_FILTER:
 		{
-			key = Utils::String::toUpper(game->metadata.get("publisher"));
+			key = Utils::String::toUpper(game->metadata.get(META_PUBLISHER));
 			key = Utils::String::trim(key);
 
 			if ((getSecondary && !key.empty()) || (!getSecondary && key.empty()))
-				key = Utils::String::toUpper(game->metadata.get("developer"));
+				key = Utils::String::toUpper(game->metadata.get(META_DEVELOPER));
 			else
-				key = Utils::String::toUpper(game->metadata.get("publisher"));
+				key = Utils::String::toUpper(game->metadata.get(META_PUBLISHER));
 			break;
 		}
 		case RATINGS_FILTER:
@@ -133,19 +157,13 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 			int ratingNumber = 0;
 			if (!getSecondary)
 			{
-				std::string ratingString = game->metadata.get("rating");
-				if (!ratingString.empty()) {
-					try {
-						ratingNumber = (int)((std::stod(ratingString)*5)+0.5);
-						if (ratingNumber < 0)
-							ratingNumber = 0;
-
-						key = std::to_string(ratingNumber) + " STARS";
-					}
-					catch (int e)
-					{
-						LOG(LogError) << "Error parsing Rating (invalid value, exception nr.): " << ratingString << ", " << e;
-					}
+				// the rating is parsed once when it's set, text that isn't a number counts as 0
+				if (!game->metadata.get(META_RATING).empty()) {
+					ratingNumber = (int)((game->metadata.getFloat(META_RATING)*5)+0.5);
+					if (ratingNumber < 0)
+						ratingNumber = 0;
+
+					key = std::to_string(ratingNumber) + " STARS";
 				}
 			}
 			break;
@@ -154,21 +172,21 @@ std::string FileFilterIndex::getIndexableKey(FileData* game, FilterIndexType typ
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = Utils::String::toUpper(game->metadata.get("favorite"));
+			key = Utils::String::toUpper(game->metadata.get(META_FAVORITE));
 			break;
 		}
 		case HIDDEN_FILTER:
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = Utils::String::toUpper(game->metadata.get("hidden"));
+			key = Utils::String::toUpper(game->metadata.get(META_HIDDEN));
 			break;
 		}
 		case KIDGAME_FILTER:
 		{
 			if (game->getType() != GAME)
 				return "FALSE";
-			key = Utils::String::toUpper(game->metadata.get("kidgame"));
+			key = Utils::String::toUpper(game->metadata.get(META_KIDGAME));
 			break;
 		}
 		default:
@@ -191,6 +209,8 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageFavoritesEntryInIndex(game);
 	manageHiddenEntryInIndex(game);
 	manageKidGameEntryInIndex(game);
+	addToColumns(game);
+	mChangeCount++;
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
@@ -202,10 +222,302 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageFavoritesEntryInIndex(game, true);
 	manageHiddenEntryInIndex(game, true);
 	manageKidGameEntryInIndex(game, true);
+	removeFromColumns(game);
+	mChangeCount++;
+}
+
+unsigned int FileFilterIndex::getValueId(const std::string& key)
+{
+	auto it = mValueIds.find(key);
+	if (it != mValueIds.cend())
+		return it->second;
+
+	const unsigned int id = (unsigned int)mValueNames.size();
+	mValueNames.push_back(key);
+	mValueIds[key] = id;
+	return id;
+}
+
+void FileFilterIndex::addToColumns(FileData* game)
+{
+	if (game->getType() != GAME)
+		return;
+
+	unsigned int slot;
+	auto it = mSlots.find(game);
+	if (it != mSlots.cend())
+	{
+		// indexed again without being removed, the keys are simply replaced
+		slot = it->second;
+	}
+	else if (!mFreeSlots.empty())
+	{
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+		mSlotFiles[slot] = game;
+		mSlots[game] = slot;
+	}
+	else
+	{
+		slot = (unsigned int)mSlotFiles.size();
+		mSlotFiles.push_back(game);
+		mSlotStamps.push_back(0);
+		mSlots[game] = slot;
+		for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+		{
+			mColumns[i].primary.push_back(NO_VALUE);
+			mColumns[i].secondary.push_back(NO_VALUE);
+		}
+	}
+
+	mSlotStamps[slot] = game->metadata.getChangeStamp();
+
+	for (std::vector<FilterDataDecl>::const_iterator decl = filterDataDecl.cbegin(); decl != filterDataDecl.cend(); ++decl )
+	{
+		FilterColumn& column = mColumns[(*decl).type];
+		column.primary[slot] = getValueId(getIndexableKey(game, (*decl).type, false));
+
+		// same as in showFileByKeys(), an unknown secondary key never matches
+		std::string secKey;
+		if ((*decl).hasSecondaryKey)
+			secKey = getIndexableKey(game, (*decl).type, true);
+		column.secondary[slot] = (secKey.empty() || secKey == UNKNOWN_LABEL) ? NO_VALUE : getValueId(secKey);
+	}
+}
+
+void FileFilterIndex::removeFromColumns(FileData* game)
+{
+	auto it = mSlots.find(game);
+	if (it == mSlots.cend())
+		return;
+
+	const unsigned int slot = it->second;
+	for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+	{
+		mColumns[i].primary[slot] = NO_VALUE;
+		mColumns[i].secondary[slot] = NO_VALUE;
+	}
+
+	mSlotFiles[slot] = NULL;
+	mFreeSlots.push_back(slot);
+	mSlots.erase(it);
+}
+
+void FileFilterIndex::updateChangedSlots()
+{
+	// metadata may be set without the game being indexed again, its keys are taken again once that shows
+	for (size_t slot = 0; slot < mSlotFiles.size(); slot++)
+	{
+		FileData* game = mSlotFiles[slot];
+		if (game != NULL && mSlotStamps[slot] != game->metadata.getChangeStamp())
+		{
+			addToColumns(game);
+			mChangeCount++;
+		}
+	}
+}
+
+void FileFilterIndex::updateShownGames()
+{
+	if (mShownChangeCount == mChangeCount)
+		return;
+
+	mShownGames.assign((mSlotFiles.size() + 63) / 64, ~(uint64_t)0);
+
+	// within a filter type any of the selected keys matches, across filter types all of them have to
+	std::vector<uint64_t> mask;
+	for (std::vector<FilterDataDecl>::const_iterator decl = filterDataDecl.cbegin(); decl != filterDataDecl.cend(); ++decl )
+	{
+		mShownValues[(*decl).type].clear();
+		if (!*((*decl).filteredByRef))
+			continue;
+
+		getKeySelection(*(*decl).currentFilteredKeys, mShownValues[(*decl).type]);
+		getKeyMask((*decl).type, *(*decl).currentFilteredKeys, mask);
+		for (size_t word = 0; word < mShownGames.size(); word++)
+			mShownGames[word] &= mask[word];
+	}
+
+	mShownChangeCount = mChangeCount;
+}
+
+void FileFilterIndex::updateShownGame(unsigned int slot)
+{
+	// the same test as updateShownGames(), for just this slot
+	bool shown = true;
+	for (std::vector<FilterDataDecl>::const_iterator decl = filterDataDecl.cbegin(); decl != filterDataDecl.cend(); ++decl )
+	{
+		if (!*((*decl).filteredByRef))
+			continue;
+
+		std::vector<unsigned char>& selected = mShownValues[(*decl).type];
+		const unsigned int primary   = mColumns[(*decl).type].primary[slot];
+		const unsigned int secondary = mColumns[(*decl).type].secondary[slot];
+
+		// a key that is new since may be one of the selected ones
+		if (primary >= selected.size() || secondary >= selected.size())
+			getKeySelection(*(*decl).currentFilteredKeys, selected);
+
+		shown = shown && (selected[primary] | selected[secondary]);
+	}
+
+	const uint64_t bit = (uint64_t)1 << (slot % 64);
+	if (shown)
+		mShownGames[slot / 64] |= bit;
+	else
+		mShownGames[slot / 64] &= ~bit;
+}
+
+void FileFilterIndex::getKeySelection(const std::vector<std::string>& keys, std::vector<unsigned char>& selected)
+{
+	selected.assign(mValueNames.size(), 0);
+	for (std::vector<std::string>::const_iterator key = keys.cbegin(); key != keys.cend(); ++key )
+	{
+		auto id = mValueIds.find(*key);
+		if (id != mValueIds.cend())
+			selected[id->second] = 1;
+	}
+}
+
+void FileFilterIndex::getKeyMask(FilterIndexType type, const std::vector<std::string>& keys, std::vector<uint64_t>& mask)
+{
+	std::vector<unsigned char> selected;
+	getKeySelection(keys, selected);
+
+	const size_t numSlots = mSlotFiles.size();
+	mask.resize((numSlots + 63) / 64);
+
+	const unsigned int* primary   = mColumns[type].primary.data();
+	const unsigned int* secondary = mColumns[type].secondary.data();
+	for (size_t word = 0; word < mask.size(); word++)
+	{
+		const size_t first = word * 64;
+		const size_t count = (numSlots - first < 64) ? numSlots - first : 64;
+
+		uint64_t bits = 0;
+		for (size_t bit = 0; bit < count; bit++)
+			bits |= (uint64_t)(selected[primary[first + bit]] | selected[secondary[first + bit]]) << bit;
+
+		mask[word] = bits;
+	}
+}
+
+static int countBits(uint64_t bits)
+{
+	bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+	bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+	bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((bits * 0x0101010101010101ULL) >> 56);
+}
+
+int FileFilterIndex::getFilterCounts(const std::map<FilterIndexType, std::vector<std::string>>& selection, std::map<FilterIndexType, std::map<std::string, int>>& keyCounts)
+{
+	updateChangedSlots();
+
+	// the masks of the selection are kept, so toggling a key only scans the column of its filter type again
+	if (mSelectionChangeCount != mChangeCount)
+	{
+		for (int i = 0; i < FILTER_TYPE_COUNT; i++)
+		{
+			mSelectionKeys[i].clear();
+			mSelectionMasks[i].clear();
+		}
+		mSelectionChangeCount = mChangeCount;
+	}
+
+	const size_t numSlots = mSlotFiles.size();
+	const size_t numWords = (numSlots + 63) / 64;
+
+	// free slots don't count
+	std::vector<uint64_t> used(numWords, 0);
+	for (size_t slot = 0; slot < numSlots; slot++)
+	{
+		if (mSlotFiles[slot] != NULL)
+			used[slot / 64] |= (uint64_t)1 << (slot % 64);
+	}
+
+	for (std::vector<FilterDataDecl>::const_iterator decl = filterDataDecl.cbegin(); decl != filterDataDecl.cend(); ++decl )
+	{
+		const FilterIndexType type = (*decl).type;
+		auto it = selection.find(type);
+		const std::vector<std::string> keys = (it != selection.cend()) ? it->second : std::vector<std::string>();
+
+		if (keys == mSelectionKeys[type])
+			continue;
+
+		mSelectionKeys[type] = keys;
+		if (keys.empty())
+			mSelectionMasks[type].clear();
+		else
+			getKeyMask(type, keys, mSelectionMasks[type]);
+	}
+
+	int numMatching = 0;
+	std::vector<uint64_t> others;
+	std::vector<int> valueCounts;
+	for (std::vector<FilterDataDecl>::const_iterator decl = filterDataDecl.cbegin(); decl != filterDataDecl.cend(); ++decl )
+	{
+		const FilterIndexType type = (*decl).type;
+
+		// a key counts the games it would leave with the other filter types as selected
+		others = used;
+		for (std::vector<FilterDataDecl>::const_iterator other = filterDataDecl.cbegin(); other != filterDataDecl.cend(); ++other )
+		{
+			const std::vector<uint64_t>& mask = mSelectionMasks[(*other).type];
+			if ((*other).type == type || mask.empty())
+				continue;
+
+			for (size_t word = 0; word < numWords; word++)
+				others[word] &= mask[word];
+		}
+
+		if (decl == filterDataDecl.cbegin())
+		{
+			const std::vector<uint64_t>& mask = mSelectionMasks[type];
+			for (size_t word = 0; word < numWords; word++)
+				numMatching += countBits(mask.empty() ? others[word] : others[word] & mask[word]);
+		}
+
+		valueCounts.assign(mValueNames.size(), 0);
+		const unsigned int* primary   = mColumns[type].primary.data();
+		const unsigned int* secondary = mColumns[type].secondary.data();
+		for (size_t word = 0; word < numWords; word++)
+		{
+			const uint64_t bits = others[word];
+			if (bits == 0)
+				continue;
+
+			for (size_t bit = 0; bit < 64; bit++)
+			{
+				if (!((bits >> bit) & 1))
+					continue;
+
+				const size_t slot = word * 64 + bit;
+				valueCounts[primary[slot]]++;
+				if (secondary[slot] != primary[slot])
+					valueCounts[secondary[slot]]++;
+			}
+		}
+
+		std::map<std::string, int>& counts = keyCounts[type];
+		for (size_t id = 1; id < valueCounts.size(); id++)
+		{
+			if (valueCounts[id] > 0)
+				counts[mValueNames[id]] += valueCounts[id];
+		}
+	}
+
+	// the games of the custom collections in the bundle are indexed by their collections
+	for (std::vector<FileFilterIndex*>::const_iterator it = mImportedIndexes.cbegin(); it != mImportedIndexes.cend(); ++it )
+		numMatching += (*it)->getFilterCounts(selection, keyCounts);
+
+	return numMatching;
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
 {
+	mChangeCount++;
+
 	// test if it exists before setting
 	if(type == NONE)
 	{
@@ -216,7 +528,7 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 		for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
 			if ((*it).type == type)
 			{
-				FilterDataDecl filterData = (*it);
+				const FilterDataDecl& filterData = (*it);
 				*(filterData.filteredByRef) = values->size() > 0;
 				filterData.currentFilteredKeys->clear();
 				for (std::vector<std::string>::const_iterator vit = values->cbegin(); vit != values->cend(); ++vit ) {
@@ -233,9 +545,11 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 
 void FileFilterIndex::clearAllFilters()
 {
+	mChangeCount++;
+
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it )
 	{
-		FilterDataDecl filterData = (*it);
+		const FilterDataDecl& filterData = (*it);
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
@@ -301,7 +615,7 @@ bool FileFilterIndex::showFile(FileData* game)
 	// if folder, needs further inspection - i.e. see if folder contains at least one element
 	// that should be shown
 	if (game->getType() == FOLDER) {
-		std::vector<FileData*> children = game->getChildren();
+		const std::vector<FileData*>& children = game->getChildren();
 		// iterate through all of the children, until there's a match
 
 		for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it ) {
@@ -313,10 +627,35 @@ bool FileFilterIndex::showFile(FileData* game)
 		return false;
 	}
 
+	auto slot = mSlots.find(game);
+	if (slot == mSlots.cend())
+	{
+		// not indexed here, i.e. the games of the custom collections in the bundle
+		return showFileByKeys(game);
+	}
+
+	updateShownGames();
+
+	// same as updateChangedSlots(), for just this game. Only its bit is updated, so the rest of a list that
+	// changed a lot since isn't filtered again for every game in it
+	if (mSlotStamps[slot->second] != game->metadata.getChangeStamp())
+	{
+		addToColumns(game);
+		mChangeCount++;
+
+		updateShownGame(slot->second);
+		mShownChangeCount = mChangeCount;
+	}
+
+	return (mShownGames[slot->second / 64] >> (slot->second % 64)) & 1;
+}
+
+bool FileFilterIndex::showFileByKeys(FileData* game)
+{
 	bool keepGoing = false;
 
 	for (std::vector<FilterDataDecl>::const_iterator it = filterDataDecl.cbegin(); it != filterDataDecl.cend(); ++it ) {
-		FilterDataDecl filterData = (*it);
+		const FilterDataDecl& filterData = (*it);
 		if(*(filterData.filteredByRef))
 		{
 			// try to find a match
@@ -347,26 +686,19 @@ bool FileFilterIndex::showFile(FileData* game)
 	return keepGoing;
 }
 
-bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
+bool FileFilterIndex::isKeyBeingFilteredBy(const std::string& key, FilterIndexType type)
 {
-	const FilterIndexType filterTypes[7] = { FAVORITES_FILTER, GENRE_FILTER, PLAYER_FILTER, PUBDEV_FILTER, RATINGS_FILTER,HIDDEN_FILTER, KIDGAME_FILTER };
-	std::vector<std::string> filterKeysList[7] = { favoritesIndexFilteredKeys, genreIndexFilteredKeys, playersIndexFilteredKeys, pubDevIndexFilteredKeys, ratingsIndexFilteredKeys, hiddenIndexFilteredKeys, kidGameIndexFilteredKeys };
+	const FilterDataDecl* filterData = getFilterDataDecl(type);
+	if (filterData == NULL)
+		return false;
 
-	for (int i = 0; i < 7; i++)
+	for (std::vector<std::string>::const_iterator it = filterData->currentFilteredKeys->cbegin(); it != filterData->currentFilteredKeys->cend(); ++it )
 	{
-		if (filterTypes[i] == type)
+		if (key == (*it))
 		{
-			for (std::vector<std::string>::const_iterator it = filterKeysList[i].cbegin(); it != filterKeysList[i].cend(); ++it )
-			{
-				if (key == (*it))
-				{
-					return true;
-				}
-			}
-			return false;
+			return true;
 		}
 	}
-
 	return false;
 }
 
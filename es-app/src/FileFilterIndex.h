@@ -3,6 +3,8 @@
 #define ES_APP_FILE_FILTER_INDEX_H
 
 #include <map>
+#include <stdint.h>
+#include <unordered_map>
 #include <vector>
 #include <string>
 
@@ -44,7 +46,7 @@ public:
 	void debugPrintIndexes();
 	bool showFile(FileData* game);
 	bool isFiltered() { return (filterByGenre || filterByPlayers || filterByPubDev || filterByRatings || filterByFavorites || filterByHidden || filterByKidGame); };
-	bool isKeyBeingFilteredBy(std::string key, FilterIndexType type);
+	bool isKeyBeingFilteredBy(const std::string& key, FilterIndexType type);
 	std::vector<FilterDataDecl>& getFilterDataDecls();
 
 	void importIndex(FileFilterIndex* indexToImport);
@@ -52,9 +54,40 @@ public:
 	void resetFilters();
 	void setUIModeFilters();
 
+	// What the filter menu shows while keys are being toggled, with the keys in selection selected instead of the
+	// current filters (a type without keys doesn't filter). Returns the number of games that would be shown, and
+	// sets for every key how many games it would leave together with what's selected for the other filter types.
+	int getFilterCounts(const std::map<FilterIndexType, std::vector<std::string>>& selection, std::map<FilterIndexType, std::map<std::string, int>>& keyCounts);
+
+	// changes whenever the filters or the indexed games change, lets callers know that what showFile() returns may have changed
+	inline unsigned int getChangeCount() const { return mChangeCount; }
+
 private:
+	// Every indexed game gets a slot, and for every filter type a column holds the ids of the keys of the game in
+	// that slot. Applying the filters scans the columns once into a bitset of the shown slots, showFile() then only
+	// has to test a bit until the filters or the indexed games change again.
+	struct FilterColumn
+	{
+		std::vector<unsigned int> primary;   // value id of the key
+		std::vector<unsigned int> secondary; // value id of the secondary key, NO_VALUE if there's none to match
+	};
+
+	static const unsigned int NO_VALUE = 0;
+	static const int FILTER_TYPE_COUNT = KIDGAME_FILTER + 1;
+
 	std::vector<FilterDataDecl> filterDataDecl;
 	std::string getIndexableKey(FileData* game, FilterIndexType type, bool getSecondary);
+	const FilterDataDecl* getFilterDataDecl(FilterIndexType type) const;
+
+	unsigned int getValueId(const std::string& key);
+	void addToColumns(FileData* game);
+	void removeFromColumns(FileData* game);
+	void updateChangedSlots();
+	void updateShownGames();
+	void updateShownGame(unsigned int slot);
+	void getKeySelection(const std::vector<std::string>& keys, std::vector<unsigned char>& selected);
+	void getKeyMask(FilterIndexType type, const std::vector<std::string>& keys, std::vector<uint64_t>& mask);
+	bool showFileByKeys(FileData* game);
 
 	void manageGenreEntryInIndex(FileData* game, bool remove = false);
 	void managePlayerEntryInIndex(FileData* game, bool remove = false);
@@ -92,7 +125,29 @@ private:
 	std::vector<std::string> hiddenIndexFilteredKeys;
 	std::vector<std::string> kidGameIndexFilteredKeys;
 
+	std::unordered_map<const FileData*, unsigned int> mSlots;
+	std::vector<FileData*> mSlotFiles; // NULL for free slots
+	std::vector<unsigned int> mSlotStamps; // metadata change stamp of the game the keys of the slot were taken from
+	std::vector<unsigned int> mFreeSlots;
+	FilterColumn mColumns[FILTER_TYPE_COUNT];
+
+	// keys of all filter types share the ids, NO_VALUE is the empty string which is never filtered for
+	std::vector<std::string> mValueNames;
+	std::unordered_map<std::string, unsigned int> mValueIds;
+
+	std::vector<uint64_t> mShownGames;
+	std::vector<unsigned char> mShownValues[FILTER_TYPE_COUNT]; // value ids selected by the filters mShownGames was computed for
+	unsigned int mShownChangeCount; // change count mShownGames was computed for
+
+	// masks of the last selection passed to getFilterCounts(), an empty mask doesn't filter
+	std::vector<std::string> mSelectionKeys[FILTER_TYPE_COUNT];
+	std::vector<uint64_t> mSelectionMasks[FILTER_TYPE_COUNT];
+	unsigned int mSelectionChangeCount;
+
+	std::vector<FileFilterIndex*> mImportedIndexes;
+
 	FileData* mRootFolder;
+	unsigned int mChangeCount;
 
 };
 
@@ -3,9 +3,34 @@
 #include "utils/StringUtil.h"
 #include "Settings.h"
 #include "Log.h"
+#include <algorithm>
+#include <atomic>
+#include <ctype.h>
+#include <mutex>
 
 namespace FileSorts
 {
+	// the leading article settings the name keys were made with, keys of an older generation get remade
+	static std::mutex               sNameKeyMutex;
+	static std::atomic<unsigned int> sNameKeyGeneration(1);
+	static bool                     sIgnoreArticles = false;
+	static std::string              sArticlesSetting;
+	static std::vector<std::string> sArticles; // upper case, with the trailing space
+
+	// same result as toUpper(string1).compare(toUpper(string2)) < 0, without the copies
+	static bool lessIgnoreCase(const std::string& string1, const std::string& string2)
+	{
+		const size_t length = std::min(string1.length(), string2.length());
+		for(size_t i = 0; i < length; i++)
+		{
+			const unsigned char c1 = (unsigned char)toupper(string1[i]);
+			const unsigned char c2 = (unsigned char)toupper(string2[i]);
+			if(c1 != c2)
+				return c1 < c2;
+		}
+
+		return string1.length() < string2.length();
+	}
 
 	const FileData::SortType typesArr[] = {
 		FileData::SortType(&compareName, true, "name, ascending"),
@@ -44,24 +69,12 @@ namespace FileSorts
 	//returns if file1 should come before file2
 	bool compareName(const FileData* file1, const FileData* file2)
 	{
-		// we compare the actual metadata name, as collection files have the system appended which messes up the order
-		std::string name1 = Utils::String::toUpper(file1->metadata.get("sortname"));
-		std::string name2 = Utils::String::toUpper(file2->metadata.get("sortname"));
-		if(name1.empty()){
-			name1 = Utils::String::toUpper(file1->metadata.get("name"));
-		}
-		if(name2.empty()){
-			name2 = Utils::String::toUpper(file2->metadata.get("name"));
-		}
-
-		ignoreLeadingArticles(name1, name2);
-
-		return name1.compare(name2) < 0;
+		return getNameKey(file1).compare(getNameKey(file2)) < 0;
 	}
 
 	bool compareRating(const FileData* file1, const FileData* file2)
 	{
-		return file1->metadata.getFloat("rating") < file2->metadata.getFloat("rating");
+		return file1->metadata.getFloat(META_RATING) < file2->metadata.getFloat(META_RATING);
 	}
 
 	bool compareTimesPlayed(const FileData* file1, const FileData* file2)
@@ -69,7 +82,7 @@ namespace FileSorts
 		//only games have playcount metadata
 		if(file1->metadata.getType() == GAME_METADATA && file2->metadata.getType() == GAME_METADATA)
 		{
-			return (file1)->metadata.getInt("playcount") < (file2)->metadata.getInt("playcount");
+			return (file1)->metadata.getInt(META_PLAYCOUNT) < (file2)->metadata.getInt(META_PLAYCOUNT);
 		}
 
 		return false;
@@ -77,75 +90,91 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("lastplayed") < (file2)->metadata.get("lastplayed");
+		// parsed once when it's set, comparing the times is cheaper than the ISO strings
+		return (file1)->metadata.getTime(META_LASTPLAYED) < (file2)->metadata.getTime(META_LASTPLAYED);
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->metadata.getInt("players") < (file2)->metadata.getInt("players");
+		return (file1)->metadata.getInt(META_PLAYERS) < (file2)->metadata.getInt(META_PLAYERS);
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
 		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
 		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->metadata.get("releasedate") < (file2)->metadata.get("releasedate");
+		return (file1)->metadata.get(META_RELEASEDATE) < (file2)->metadata.get(META_RELEASEDATE);
 	}
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = Utils::String::toUpper(file1->metadata.get("genre"));
-		std::string genre2 = Utils::String::toUpper(file2->metadata.get("genre"));
-		return genre1.compare(genre2) < 0;
+		return lessIgnoreCase(file1->metadata.get(META_GENRE), file2->metadata.get(META_GENRE));
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = Utils::String::toUpper(file1->metadata.get("developer"));
-		std::string developer2 = Utils::String::toUpper(file2->metadata.get("developer"));
-		return developer1.compare(developer2) < 0;
+		return lessIgnoreCase(file1->metadata.get(META_DEVELOPER), file2->metadata.get(META_DEVELOPER));
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = Utils::String::toUpper(file1->metadata.get("publisher"));
-		std::string publisher2 = Utils::String::toUpper(file2->metadata.get("publisher"));
-		return publisher1.compare(publisher2) < 0;
+		return lessIgnoreCase(file1->metadata.get(META_PUBLISHER), file2->metadata.get(META_PUBLISHER));
 	}
 
 	bool compareSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string system1 = Utils::String::toUpper(file1->getSystemName());
-		std::string system2 = Utils::String::toUpper(file2->getSystemName());
-		return system1.compare(system2) < 0;
+		return lessIgnoreCase(file1->getSystemName(), file2->getSystemName());
 	}
 
-	//If option is enabled, ignore leading articles by temporarily modifying the name prior to sorting
-	//(Artciles are defined within the settings config file)
-	void ignoreLeadingArticles(std::string &name1, std::string &name2) {
+	const std::string& getNameKey(const FileData* file)
+	{
+		const unsigned int generation = sNameKeyGeneration;
+		const std::string* cached = file->metadata.getNameKey(generation);
+		if(cached)
+			return *cached;
 
-		if (Settings::getInstance()->getBool("IgnoreLeadingArticles"))
+		// we compare the actual metadata name, as collection files have the system appended which messes up the order
+		const std::string& sortName = file->metadata.get(META_SORTNAME);
+		std::string key = Utils::String::toUpper(sortName.empty() ? file->metadata.get(META_NAME) : sortName);
+
+		//If option is enabled, ignore leading articles (articles are defined within the settings config file)
+		//every occurrence of a leading article is dropped, not only the first one
+		if(sIgnoreArticles)
 		{
+			for(auto it = sArticles.cbegin(); it != sArticles.cend(); it++)
+			{
+				if(Utils::String::startsWith(key, *it))
+					key = Utils::String::replace(key, *it, "");
+			}
+		}
 
-			std::vector<std::string> articles = Utils::String::delimitedStringToVector(Settings::getInstance()->getString("LeadingArticles"), ",");
+		return file->metadata.setNameKey(generation, key);
+	}
 
-			for(Utils::String::stringVector::iterator it = articles.begin(); it != articles.end(); it++)
-			{
-			
-				if (Utils::String::startsWith(Utils::String::toUpper(name1), Utils::String::toUpper(it[0]) + " ")) {
-					name1 = Utils::String::replace(Utils::String::toUpper(name1), Utils::String::toUpper(it[0]) + " ", "");
-				}
+	void updateNameKeySettings()
+	{
+		const bool ignoreArticles = Settings::getInstance()->getBool("IgnoreLeadingArticles");
+		const std::string articles = Settings::getInstance()->getString("LeadingArticles");
 
-				if (Utils::String::startsWith(Utils::String::toUpper(name2), Utils::String::toUpper(it[0]) + " ")) {
-					name2 = Utils::String::replace(Utils::String::toUpper(name2), Utils::String::toUpper(it[0]) + " ", "");
-				}
+		std::unique_lock<std::mutex> lock(sNameKeyMutex);
 
-			}
+		if(ignoreArticles == sIgnoreArticles && articles == sArticlesSetting)
+			return;
 
-		}
+		sIgnoreArticles  = ignoreArticles;
+		sArticlesSetting = articles;
+		sArticles.clear();
+
+		const std::vector<std::string> list = Utils::String::delimitedStringToVector(articles, ",");
+		for(auto it = list.cbegin(); it != list.cend(); it++)
+			sArticles.push_back(Utils::String::toUpper(*it) + " ");
 
+		sNameKeyGeneration++;
+	}
+
+	unsigned int getNameKeyGeneration()
+	{
+		return sNameKeyGeneration;
 	}
 
 };
@@ -18,7 +18,12 @@ namespace FileSorts
 	bool comparePublisher(const FileData* file1, const FileData* file2);
 	bool compareSystem(const FileData* file1, const FileData* file2);
 
-	void ignoreLeadingArticles(std::string &name1, std::string &name2);
+	// The upper cased sortname (or name) without leading articles that compareName() compares, cached in the metadata.
+	const std::string& getNameKey(const FileData* file);
+	// Drops all cached name keys if the leading article settings changed since the keys were made.
+	void updateNameKeySettings();
+	// Changes whenever updateNameKeySettings() dropped the keys.
+	unsigned int getNameKeyGeneration();
 
 	extern const std::vector<FileData::SortType> SortTypes;
 };
@@ -0,0 +1,446 @@
+#include "GameSearchIndex.h"
+
+#include "utils/ThreadPool.h"
+#include "FileData.h"
+#include "FileFilterIndex.h"
+#include "Log.h"
+#include "SystemData.h"
+#include <algorithm>
+#include <chrono>
+
+#define FIELD_SEPARATOR '\x1f'
+
+GameSearchIndex* GameSearchIndex::sInstance = nullptr;
+
+void GameSearchIndex::init()
+{
+	if(!sInstance)
+	{
+		sInstance = new GameSearchIndex();
+		sInstance->startBuild();
+	}
+
+} // init
+
+void GameSearchIndex::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+GameSearchIndex* GameSearchIndex::getInstance()
+{
+	return sInstance;
+
+} // getInstance
+
+void GameSearchIndex::onGameChanged(FileData* game)
+{
+	if(sInstance)
+		sInstance->updateGame(game);
+
+} // onGameChanged
+
+void GameSearchIndex::onGameRemoved(FileData* game)
+{
+	if(sInstance)
+		sInstance->removeGame(game);
+
+} // onGameRemoved
+
+GameSearchIndex::GameSearchIndex()
+{
+
+} // GameSearchIndex
+
+GameSearchIndex::~GameSearchIndex()
+{
+	// the worker only uses its own copy of the fields, but it shouldn't outlive the pool
+	if(mBuilding.valid())
+		Utils::ThreadPool::getShared()->wait(mBuilding, Utils::ThreadPool::PRIORITY_LOW);
+
+} // ~GameSearchIndex
+
+// Letters are lower cased and kept together with digits and the bytes of multi byte characters, everything
+// else separates words by a single space.
+static void appendNormalized(std::string& text, const std::string& value)
+{
+	const size_t start = text.size();
+	bool         space = true;
+
+	for(auto it = value.cbegin(); it != value.cend(); ++it)
+	{
+		const unsigned char c = (unsigned char)*it;
+
+		if((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80)
+		{
+			text += (char)c;
+			space = false;
+		}
+		else if(c >= 'A' && c <= 'Z')
+		{
+			text += (char)(c - 'A' + 'a');
+			space = false;
+		}
+		else if(!space)
+		{
+			text += ' ';
+			space = true;
+		}
+	}
+
+	if(text.size() > start && text.back() == ' ')
+		text.pop_back();
+}
+
+static inline bool isWordChar(char c)
+{
+	return c != ' ' && c != FIELD_SEPARATOR;
+}
+
+static inline uint32_t makeTrigram(const char* chars)
+{
+	return ((uint32_t)(unsigned char)chars[0] << 16) | ((uint32_t)(unsigned char)chars[1] << 8) | (uint32_t)(unsigned char)chars[2];
+}
+
+static inline uint32_t makeBigram(const char* chars)
+{
+	return ((uint32_t)(unsigned char)chars[0] << 8) | (uint32_t)(unsigned char)chars[1];
+}
+
+static inline void addId(std::vector<uint32_t>& ids, uint32_t id)
+{
+	if(ids.empty() || ids.back() != id)
+		ids.push_back(id);
+}
+
+// -1 if a word is missing, otherwise higher the better the entry matches
+static int scoreText(const std::string& text, unsigned int nameEnd, unsigned int sortNameEnd, const std::vector<std::string>& words, const std::string& query)
+{
+	int score = 0;
+
+	for(auto it = words.cbegin(); it != words.cend(); ++it)
+	{
+		// the name comes first, so the first occurrence is in the best field there is one in
+		const size_t pos = text.find(*it);
+		if(pos == std::string::npos)
+			return -1;
+
+		if(pos < nameEnd)          score += 100;
+		else if(pos < sortNameEnd) score += 60;
+		else                       score += 20;
+
+		if(pos == 0 || !isWordChar(text[pos - 1]))
+			score += 20;
+	}
+
+	if(query.size() <= nameEnd && text.compare(0, query.size(), query) == 0)
+	{
+		score += 200;
+		if(query.size() == nameEnd)
+			score += 300;
+	}
+
+	return score;
+}
+
+GameSearchIndex::Fields GameSearchIndex::getFields(FileData* game)
+{
+	Fields fields;
+	fields.game      = game;
+	fields.values[0] = game->getName();
+	fields.values[1] = game->metadata.get(META_SORTNAME);
+	fields.values[2] = game->metadata.get(META_DEVELOPER);
+	fields.values[3] = game->metadata.get(META_PUBLISHER);
+	fields.values[4] = game->metadata.get(META_GENRE);
+	return fields;
+
+} // getFields
+
+void GameSearchIndex::addEntry(Index& index, const Fields& fields)
+{
+	Entry entry;
+	entry.game = fields.game;
+
+	appendNormalized(entry.text, fields.values[0]);
+	entry.nameEnd = (unsigned int)entry.text.size();
+	entry.text += FIELD_SEPARATOR;
+	appendNormalized(entry.text, fields.values[1]);
+	entry.sortNameEnd = (unsigned int)entry.text.size();
+
+	for(int i = 2; i < 5; i++)
+	{
+		entry.text += FIELD_SEPARATOR;
+		appendNormalized(entry.text, fields.values[i]);
+	}
+
+	// ids only ever grow, so appending keeps the lists sorted
+	const uint32_t     id   = (uint32_t)index.entries.size();
+	const std::string& text = entry.text;
+	for(size_t i = 0; i < text.size(); i++)
+	{
+		if(!isWordChar(text[i]))
+			continue;
+
+		if(i == 0 || !isWordChar(text[i - 1]))
+			addId(index.initials[(unsigned char)text[i]], id);
+
+		if(i + 1 < text.size() && isWordChar(text[i + 1]))
+		{
+			addId(index.bigrams[makeBigram(&text[i])], id);
+
+			if(i + 2 < text.size() && isWordChar(text[i + 2]))
+				addId(index.trigrams[makeTrigram(&text[i])], id);
+		}
+	}
+
+	index.ids[fields.game] = id;
+	index.entries.push_back(std::move(entry));
+
+} // addEntry
+
+void GameSearchIndex::removeEntry(Index& index, FileData* game)
+{
+	auto it = index.ids.find(game);
+	if(it == index.ids.cend())
+		return;
+
+	// the lists keep the id, removed entries are skipped when searching
+	Entry& entry = index.entries[it->second];
+	entry.game = NULL;
+	std::string().swap(entry.text);
+
+	index.ids.erase(it);
+	index.numRemoved++;
+
+} // removeEntry
+
+void GameSearchIndex::startBuild()
+{
+	// metadata is only touched on the main thread, so the fields are copied here and the worker does the rest
+	std::shared_ptr<std::vector<Fields>> fields = std::make_shared<std::vector<Fields>>();
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+	{
+		// collections hold copies of the games of the game systems, only the games themselves are indexed
+		if(!(*it)->isGameSystem() || (*it)->isCollection())
+			continue;
+
+		(*it)->getRootFolder()->visitFiles(GAME, [&fields](FileData* game) -> bool
+		{
+			fields->push_back(getFields(game));
+			return true;
+		});
+	}
+
+	mChangedWhileBuilding.clear();
+	mRemovedWhileBuilding.clear();
+
+	mBuilding = Utils::ThreadPool::getShared()->submit([fields]() -> std::shared_ptr<Index>
+	{
+		std::shared_ptr<Index> index = std::make_shared<Index>();
+		index->entries.reserve(fields->size());
+		for(auto it = fields->cbegin(); it != fields->cend(); ++it)
+			addEntry(*index, *it);
+
+		return index;
+	}, Utils::ThreadPool::PRIORITY_LOW);
+
+} // startBuild
+
+bool GameSearchIndex::adoptBuiltIndex()
+{
+	if(mBuilding.valid() && mBuilding.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		mIndex = mBuilding.get();
+
+		for(auto it = mRemovedWhileBuilding.cbegin(); it != mRemovedWhileBuilding.cend(); ++it)
+			removeEntry(*mIndex, *it);
+
+		for(auto it = mChangedWhileBuilding.cbegin(); it != mChangedWhileBuilding.cend(); ++it)
+		{
+			removeEntry(*mIndex, *it);
+			addEntry(*mIndex, getFields(*it));
+		}
+
+		mChangedWhileBuilding.clear();
+		mRemovedWhileBuilding.clear();
+
+		LOG(LogInfo) << "Search index: " << mIndex->ids.size() << " games, " << mIndex->trigrams.size() << " trigrams";
+	}
+
+	return mIndex != nullptr;
+
+} // adoptBuiltIndex
+
+bool GameSearchIndex::isReady()
+{
+	return adoptBuiltIndex();
+
+} // isReady
+
+void GameSearchIndex::waitUntilReady()
+{
+	if(mBuilding.valid())
+		Utils::ThreadPool::getShared()->wait(mBuilding, Utils::ThreadPool::PRIORITY_LOW);
+
+	adoptBuiltIndex();
+
+} // waitUntilReady
+
+void GameSearchIndex::updateGame(FileData* game)
+{
+	if(game->getType() != GAME || !game->getSystem()->isGameSystem() || game->getSystem()->isCollection())
+		return;
+
+	adoptBuiltIndex();
+
+	if(mBuilding.valid())
+		mChangedWhileBuilding.insert(game);
+
+	if(!mIndex)
+		return;
+
+	removeEntry(*mIndex, game);
+	addEntry(*mIndex, getFields(game));
+
+	// every change leaves a removed entry behind, rebuild once they make up half of the index
+	if(!mBuilding.valid() && mIndex->numRemoved > 1024 && mIndex->numRemoved > mIndex->entries.size() / 2)
+		startBuild();
+
+} // updateGame
+
+void GameSearchIndex::removeGame(FileData* game)
+{
+	if(mBuilding.valid())
+	{
+		mChangedWhileBuilding.erase(game);
+		mRemovedWhileBuilding.insert(game);
+	}
+
+	if(mIndex)
+		removeEntry(*mIndex, game);
+
+} // removeGame
+
+bool GameSearchIndex::contains(const FileData* game)
+{
+	return adoptBuiltIndex() && (mIndex->ids.find(game) != mIndex->ids.cend());
+
+} // contains
+
+std::vector<FileData*> GameSearchIndex::search(const std::string& query, size_t maxResults)
+{
+	std::vector<FileData*> results;
+	if(!adoptBuiltIndex())
+		return results;
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::string normalized;
+	appendNormalized(normalized, query);
+	if(normalized.empty())
+		return results;
+
+	std::vector<std::string> words;
+	for(size_t first = 0; first < normalized.size(); )
+	{
+		size_t last = normalized.find(' ', first);
+		if(last == std::string::npos)
+			last = normalized.size();
+
+		words.push_back(normalized.substr(first, last - first));
+		first = last + 1;
+	}
+
+	const Index& index = *mIndex;
+
+	// the candidates have all trigrams of the words, the shortest list is walked and looked up in the others.
+	// Shorter words have a list of their own, so no query has to look at every entry
+	std::vector<const std::vector<uint32_t>*> lists;
+	for(auto word = words.cbegin(); word != words.cend(); ++word)
+	{
+		if(word->size() < 3)
+		{
+			const std::unordered_map<uint32_t, std::vector<uint32_t>>& grams = (word->size() == 2) ? index.bigrams : index.initials;
+			auto it = grams.find((word->size() == 2) ? makeBigram(word->data()) : (unsigned char)(*word)[0]);
+			if(it == grams.cend())
+				return results;
+
+			lists.push_back(&it->second);
+			continue;
+		}
+
+		for(size_t i = 0; i + 2 < word->size(); i++)
+		{
+			auto it = index.trigrams.find(makeTrigram(&(*word)[i]));
+			if(it == index.trigrams.cend())
+				return results;
+
+			lists.push_back(&it->second);
+		}
+	}
+
+	std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) -> bool
+	{
+		return (a->size() != b->size()) ? (a->size() < b->size()) : (a < b);
+	});
+	lists.erase(std::unique(lists.begin(), lists.end()), lists.end());
+
+	std::vector<uint32_t> candidates = *lists.front();
+	for(size_t i = 1; i < lists.size() && !candidates.empty(); i++)
+	{
+		const std::vector<uint32_t>& list = *lists[i];
+		candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&list](uint32_t id) -> bool
+		{
+			return !std::binary_search(list.cbegin(), list.cend(), id);
+		}), candidates.end());
+	}
+
+	std::vector<std::pair<int, uint32_t>> matches;
+	for(auto it = candidates.cbegin(); it != candidates.cend(); ++it)
+	{
+		const Entry& entry = index.entries[*it];
+		if(entry.game == NULL)
+			continue;
+
+		// sharing the trigrams doesn't mean the words are there in one piece
+		const int score = scoreText(entry.text, entry.nameEnd, entry.sortNameEnd, words, normalized);
+		if(score < 0)
+			continue;
+
+		// what kiosk and kid mode hide through the filters of the system isn't found either
+		if(!entry.game->getSystem()->getIndex()->showFile(entry.game))
+			continue;
+
+		matches.push_back(std::make_pair(score, *it));
+	}
+
+	const size_t numResults = std::min(maxResults, matches.size());
+	std::partial_sort(matches.begin(), matches.begin() + numResults, matches.end(), [&index](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) -> bool
+	{
+		if(a.first != b.first)
+			return a.first > b.first;
+
+		// shorter names are closer to the query
+		const Entry& entryA = index.entries[a.second];
+		const Entry& entryB = index.entries[b.second];
+		if(entryA.nameEnd != entryB.nameEnd)
+			return entryA.nameEnd < entryB.nameEnd;
+
+		return entryA.text < entryB.text;
+	});
+
+	results.reserve(numResults);
+	for(size_t i = 0; i < numResults; i++)
+		results.push_back(index.entries[matches[i].second].game);
+
+	const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	LOG(LogDebug) << "Search for \"" << query << "\" found " << matches.size() << " games in " << elapsed << " ms";
+
+	return results;
+
+} // search
@@ -0,0 +1,95 @@
+#pragma once
+#ifndef ES_APP_GAME_SEARCH_INDEX_H
+#define ES_APP_GAME_SEARCH_INDEX_H
+
+#include <future>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class FileData;
+
+// Finds games of all game systems by name, sort name, developer, publisher and genre while the user types.
+// Every game is broken into trigrams (runs of three characters of a word), a query only has to look at the
+// games that share all trigrams of its words. Words of two characters are looked up by bigram and single
+// letters by the first letters of words. The index is built on a worker after boot and kept up to date by
+// the places that add or change games, all calls are made from the main thread.
+class GameSearchIndex
+{
+public:
+
+	static void             init       ();
+	static void             deinit     ();
+	static GameSearchIndex* getInstance(); // NULL before init()
+
+	// To be called after a game was added or its name, sort name, developer, publisher or genre may have changed.
+	static void onGameChanged(FileData* game);
+	static void onGameRemoved(FileData* game);
+
+	// The best matches for query, best first. Every word of query has to be part of one of the fields, a single
+	// letter has to start a word of them. Names matching from their start rank highest. Empty until the first
+	// build is done.
+	std::vector<FileData*> search(const std::string& query, size_t maxResults);
+
+	// False once game was removed, results of an earlier search may point to games that are gone by now.
+	bool contains(const FileData* game);
+
+	bool isReady();
+	void waitUntilReady();
+
+private:
+
+	struct Entry
+	{
+		FileData*    game;        // NULL once removed
+		std::string  text;        // the normalized fields, separated by FIELD_SEPARATOR
+		unsigned int nameEnd;     // end of the name in text
+		unsigned int sortNameEnd; // end of the sort name in text
+	};
+
+	struct Index
+	{
+		Index() : numRemoved(0) { }
+
+		std::vector<Entry>                                 entries;
+		std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams; // ids of the entries, ascending
+		std::unordered_map<uint32_t, std::vector<uint32_t>> bigrams;  // the same for two characters of a word
+		std::unordered_map<uint32_t, std::vector<uint32_t>> initials; // the same for the first letter of a word
+		std::unordered_map<const FileData*, uint32_t>        ids;
+		size_t                                             numRemoved;
+	};
+
+	// what the worker builds an entry from, copied on the main thread
+	struct Fields
+	{
+		FileData*   game;
+		std::string values[5];
+	};
+
+	 GameSearchIndex();
+	~GameSearchIndex();
+
+	void startBuild();
+	bool adoptBuiltIndex();
+	void updateGame(FileData* game);
+	void removeGame(FileData* game);
+
+	static Fields getFields(FileData* game);
+	static void   addEntry(Index& index, const Fields& fields);
+	static void   removeEntry(Index& index, FileData* game);
+
+	static GameSearchIndex* sInstance;
+
+	std::shared_ptr<Index>                  mIndex;
+	std::future<std::shared_ptr<Index>>     mBuilding;
+
+	// changes made while building, applied to the new index when it's done
+	std::unordered_set<FileData*>           mChangedWhileBuilding;
+	std::unordered_set<FileData*>           mRemovedWhileBuilding;
+
+}; // GameSearchIndex
+
+#endif // ES_APP_GAME_SEARCH_INDEX_H
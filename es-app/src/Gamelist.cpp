@@ -1,8 +1,17 @@
 #include "Gamelist.h"
 
 #include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdio.h>
+#include <unordered_map>
 
 #include "utils/FileSystemUtil.h"
+#include "utils/ThreadPool.h"
+#include "utils/TraceUtil.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
 #include "Log.h"
@@ -10,7 +19,44 @@
 #include "SystemData.h"
 #include <pugixml.hpp>
 
-FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType type)
+#if defined(_WIN32)
+#include <io.h>
+#include <Windows.h>
+#else // _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+// a gamelist that was built on the main thread and waits to be written by the background writer
+struct PendingGamelist
+{
+	PendingGamelist() : version(0), baseVersion(0) {}
+
+	std::shared_ptr<pugi::xml_document>  doc;
+	uint64_t                             version;
+	uint64_t                             baseVersion; // version doc was built on, 0 if it was read from disk
+	Utils::FileSystem::FileStamp         base;        // of the file doc was built on, unless baseVersion made it to disk
+	std::vector<GamelistWrittenCallback> onWritten;   // of this and all the versions it replaced
+};
+
+// the last version of a path the writer put on disk and the stamp the file got
+struct WrittenGamelist
+{
+	WrittenGamelist() : version(0) {}
+
+	uint64_t                     version;
+	Utils::FileSystem::FileStamp stamp;
+};
+
+static std::mutex                             sWriteMutex;
+static std::condition_variable                sWriteCondition;
+static std::map<std::string, PendingGamelist> sPendingWrites; // by write path, only the latest version of each
+static std::map<std::string, PendingGamelist> sActiveWrites;  // being written right now, at most one per path
+static std::map<std::string, WrittenGamelist> sWrittenGamelists;
+static uint64_t                               sNextVersion = 1;
+static uint64_t                               sBytesWritten = 0;
+
+FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType type, bool* created)
 {
 	FileData* root = system->getRootFolder();
 	bool contains = false;
@@ -54,7 +100,9 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 				return NULL;
 			}
 
-			FileData* file = new FileData(type, path, system->getSystemEnvData(), system);
+			FileData* file = new (system->getArena()) FileData(type, path, system->getSystemEnvData(), system);
+			if(created)
+				*created = true;
 
 			// skipping arcade assets from gamelist and add only to filesystem
 			// (fs) folders, i.e. entriess in gamelist with <folder/> and not to
@@ -88,7 +136,7 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 			}
 			// create folder filedata object
 			std::string absPath = Utils::FileSystem::resolveRelativePath(treeNode->getPath() + "/" + pathSegment, systemPath, false, true);
-			FileData* folder = new FileData(FOLDER, absPath, system->getSystemEnvData(), system);
+			FileData* folder = new (system->getArena()) FileData(FOLDER, absPath, system->getSystemEnvData(), system);
 			LOG(LogDebug) << "folder not found as FileData, adding: " << folder->getPath();
 
 			treeNode->addChild(folder);
@@ -101,7 +149,10 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	return NULL;
 }
 
-void parseGamelist(SystemData* system)
+// Loads gamelist.xml into the tree of a system. When added and changed are given, the system is already
+// loaded: created games are indexed and reported in added, existing files whose metadata differs from
+// the XML are re-indexed and reported in changed.
+static void loadGamelist(SystemData* system, std::vector<FileData*>* added, std::vector<FileData*>* changed)
 {
 	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
 	std::string xmlpath = system->getGamelistPath(false);
@@ -154,7 +205,8 @@ void parseGamelist(SystemData* system)
 				continue;
 			}
 
-			FileData* file = findOrCreateFile(system, path, type);
+			bool created = false;
+			FileData* file = findOrCreateFile(system, path, type, &created);
 			if(!file)
 			{
 				LOG(LogError) << "Error finding/creating FileData for \"" << path << "\", skipping.";
@@ -162,19 +214,61 @@ void parseGamelist(SystemData* system)
 			}
 			else if(!file->isArcadeAsset())
 			{
-				std::string defaultName = file->metadata.get("name");
-				file->metadata = MetaDataList::createFromXML(file->getType() == GAME ? GAME_METADATA : FOLDER_METADATA, fileNode, relativeTo);
+				const bool merging = (added != NULL) && !created;
+
+				// when merging into a loaded file its current name may come from the old gamelist
+				std::string defaultName = merging ? file->getDisplayName() : file->metadata.get(META_NAME);
+				MetaDataList metadata = MetaDataList::createFromXML(file->getType() == GAME ? GAME_METADATA : FOLDER_METADATA, fileNode, relativeTo);
 
 				//make sure name gets set if one didn't exist
-				if(file->metadata.get("name").empty())
-					file->metadata.set("name", defaultName);
+				if(metadata.get(META_NAME).empty())
+					metadata.set(META_NAME, defaultName);
+
+				metadata.resetChangedFlag();
+
+				if(merging)
+				{
+					// changes which are not saved yet win over the file
+					if(file->metadata.wasChanged() || metadata == file->metadata)
+						continue;
+
+					if(file->getType() == GAME)
+						system->getIndex()->removeFromIndex(file);
+					file->metadata = metadata;
+					if(file->getType() == GAME)
+						system->getIndex()->addToIndex(file);
 
-				file->metadata.resetChangedFlag();
+					changed->push_back(file);
+				}
+				else
+				{
+					file->metadata = metadata;
+
+					if(added != NULL && file->getType() == GAME && file->getParent() != NULL)
+					{
+						system->getIndex()->addToIndex(file);
+						added->push_back(file);
+					}
+				}
 			}
 		}
 	}
 }
 
+void parseGamelist(SystemData* system)
+{
+	TraceScopeDetail("parseGamelist", system->getName());
+
+	loadGamelist(system, NULL, NULL);
+}
+
+void mergeGamelist(SystemData* system, std::vector<FileData*>& added, std::vector<FileData*>& changed)
+{
+	TraceScopeDetail("mergeGamelist", system->getName());
+
+	loadGamelist(system, &added, &changed);
+}
+
 void addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* tag, SystemData* system)
 {
 	//create game and add to parent node
@@ -199,7 +293,208 @@ void addFileDataNode(pugi::xml_node& parent, const FileData* file, const char* t
 	}
 }
 
-void updateGamelist(SystemData* system)
+// Replaces path with data so that it holds either the old or the new content, even after a crash or power loss.
+// The file is only replaced while it is still the version with stamp expected, what someone else wrote since is
+// kept and merged by the RomWatcher; the changes in data stay unsaved in memory and go into the next write.
+static bool writeGamelistFile(const std::string& path, const std::string& data, const Utils::FileSystem::FileStamp& expected, Utils::FileSystem::FileStamp& written)
+{
+	const std::string tempPath = path + ".tmp";
+
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if(file == NULL)
+		return false;
+
+	bool ok = fwrite(data.data(), 1, data.size(), file) == data.size() && fflush(file) == 0;
+#if defined(_WIN32)
+	ok = ok && _commit(_fileno(file)) == 0;
+#else // _WIN32
+	ok = ok && fsync(fileno(file)) == 0;
+#endif // _WIN32
+
+	// nothing is written to it anymore and renaming keeps the stamp, it tells this write from changes made by others
+	written = Utils::FileSystem::getFileStamp(file);
+	ok = (fclose(file) == 0) && ok;
+
+	if(ok && Utils::FileSystem::getFileStamp(path) != expected)
+	{
+		LOG(LogWarning) << "\"" << path << "\" was changed by someone else while it was saved, keeping their version";
+		ok = false;
+	}
+
+#if defined(_WIN32)
+	ok = ok && MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else // _WIN32
+	ok = ok && rename(tempPath.c_str(), path.c_str()) == 0;
+
+	// the rename itself only survives a power loss once the folder is on disk as well
+	if(ok)
+	{
+		const int folder = open(Utils::FileSystem::getParent(path).c_str(), O_RDONLY);
+		if(folder >= 0)
+		{
+			fsync(folder);
+			close(folder);
+		}
+	}
+#endif // _WIN32
+
+	if(!ok)
+		Utils::FileSystem::removeFile(tempPath);
+
+	return ok;
+}
+
+// Runs on the thread pool until no newer version of path is waiting. Different paths are written in parallel,
+// the versions of one path one after the other.
+static void writePendingGamelist(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+
+	for(auto it = sPendingWrites.find(path); it != sPendingWrites.end() && sActiveWrites.find(path) == sActiveWrites.end(); it = sPendingWrites.find(path))
+	{
+		const PendingGamelist pending = (sActiveWrites[path] = it->second);
+		sPendingWrites.erase(it);
+
+		// a version that was still being written when this one was built on it is on disk by now, unless it failed
+		Utils::FileSystem::FileStamp expected = pending.base;
+		const WrittenGamelist& lastWritten = sWrittenGamelists[path];
+		if(pending.baseVersion != 0 && lastWritten.version == pending.baseVersion)
+			expected = lastWritten.stamp;
+		lock.unlock();
+
+		TraceScopeDetail("writeGamelist", path);
+		const auto startTs = std::chrono::system_clock::now();
+
+		std::ostringstream stream;
+		pending.doc->save(stream);
+		const std::string data = stream.str();
+
+		Utils::FileSystem::FileStamp stamp;
+		const bool written = writeGamelistFile(path, data, expected, stamp);
+		if(written)
+		{
+			const auto endTs = std::chrono::system_clock::now();
+			LOG(LogInfo) << "Saved \"" << path << "\" (" << data.size() << " bytes) in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
+		}
+		else
+		{
+			LOG(LogError) << "Error saving gamelist.xml to \"" << path << "\"!";
+		}
+
+		lock.lock();
+		if(written)
+		{
+			sBytesWritten += data.size();
+			sWrittenGamelists[path].version = pending.version;
+			sWrittenGamelists[path].stamp   = stamp;
+		}
+
+		// callbacks can still be added while the others run, they were waiting for this version as well
+		for(;;)
+		{
+			std::vector<GamelistWrittenCallback> onWritten;
+			onWritten.swap(sActiveWrites[path].onWritten);
+			if(onWritten.empty())
+				break;
+
+			lock.unlock();
+			for(auto cb = onWritten.cbegin(); cb != onWritten.cend(); ++cb)
+				(*cb)(written);
+			lock.lock();
+		}
+
+		sActiveWrites.erase(path);
+		sWriteCondition.notify_all();
+	}
+}
+
+// doc was built on base, see getPendingGamelist().
+static void queueGamelistWrite(const std::string& path, const std::shared_ptr<pugi::xml_document>& doc, const PendingGamelist& base, const GamelistWrittenCallback& onWritten)
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+
+	auto inserted = sPendingWrites.insert(std::make_pair(path, PendingGamelist()));
+	PendingGamelist& pending = inserted.first->second;
+
+	// a version replaced before it was written never made it to disk, this one then builds on what that one built on
+	if(inserted.second)
+	{
+		pending.baseVersion = base.version;
+		pending.base        = base.base;
+	}
+
+	pending.doc     = doc;
+	pending.version = sNextVersion++;
+	if(onWritten)
+		pending.onWritten.push_back(onWritten);
+
+	// an older version still waiting has a write queued already, one being written picks this one up when it's done
+	if(inserted.second && sActiveWrites.find(path) == sActiveWrites.end())
+		Utils::ThreadPool::getShared()->queueWorkItem([path] { writePendingGamelist(path); }, Utils::ThreadPool::PRIORITY_LOW);
+}
+
+// The newest version of the gamelist at path that isn't on disk yet, if any. What a new version is built on goes
+// to base: that version, or the stamp of the file on disk if there is none.
+static std::shared_ptr<pugi::xml_document> getPendingGamelist(const std::string& path, PendingGamelist& base)
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+
+	auto it = sPendingWrites.find(path);
+	if(it == sPendingWrites.end())
+	{
+		it = sActiveWrites.find(path);
+		if(it == sActiveWrites.end())
+		{
+			base.version = 0;
+			base.base    = Utils::FileSystem::getFileStamp(path);
+			return nullptr;
+		}
+	}
+
+	base.version = it->second.version;
+	base.base    = it->second.base;
+	return it->second.doc;
+}
+
+// Calls onWritten once the version of the gamelist at path that is waiting to be written is on disk.
+// Returns false if nothing is waiting, the file is up to date already.
+static bool whenGamelistWritten(const std::string& path, const GamelistWrittenCallback& onWritten)
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+
+	auto it = sPendingWrites.find(path);
+	if(it == sPendingWrites.end())
+	{
+		it = sActiveWrites.find(path);
+		if(it == sActiveWrites.end())
+			return false;
+	}
+
+	it->second.onWritten.push_back(onWritten);
+	return true;
+}
+
+Utils::FileSystem::FileStamp getWrittenGamelistStamp(const std::string& path)
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+
+	auto it = sWrittenGamelists.find(path);
+	return (it != sWrittenGamelists.end()) ? it->second.stamp : Utils::FileSystem::FileStamp();
+}
+
+uint64_t getGamelistBytesWritten()
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+	return sBytesWritten;
+}
+
+void flushGamelistWrites()
+{
+	std::unique_lock<std::mutex> lock(sWriteMutex);
+	sWriteCondition.wait(lock, [] { return sPendingWrites.empty() && sActiveWrites.empty(); });
+}
+
+void updateGamelist(SystemData* system, const GamelistWrittenCallback& onWritten)
 {
 	//We do this by reading the XML again, adding changes and then writing it back,
 	//because there might be information missing in our systemdata which would then miss in the new XML.
@@ -209,16 +504,25 @@ void updateGamelist(SystemData* system)
 	if(Settings::getInstance()->getBool("IgnoreGamelist"))
 		return;
 
-	pugi::xml_document doc;
+	std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
 	pugi::xml_node root;
 	std::string xmlReadPath = system->getGamelistPath(false);
+	std::string xmlWritePath = system->getGamelistPath(true);
 
 	std::string relativeTo = system->getStartPath();
 
-	if(Utils::FileSystem::exists(xmlReadPath))
+	// a version that is still waiting to be written is newer than anything on disk
+	PendingGamelist base;
+	std::shared_ptr<pugi::xml_document> pending = getPendingGamelist(xmlWritePath, base);
+	if(pending)
+	{
+		doc->reset(*pending);
+		root = doc->child("gameList");
+	}
+	else if(Utils::FileSystem::exists(xmlReadPath))
 	{
 		//parse an existing file first
-		pugi::xml_parse_result result = doc.load_file(xmlReadPath.c_str());
+		pugi::xml_parse_result result = doc->load_file(xmlReadPath.c_str());
 
 		if(!result)
 		{
@@ -226,7 +530,7 @@ void updateGamelist(SystemData* system)
 			return;
 		}
 
-		root = doc.child("gameList");
+		root = doc->child("gameList");
 		if(!root)
 		{
 			LOG(LogError) << "Could not find <gameList> node in gamelist \"" << xmlReadPath << "\"!";
@@ -234,7 +538,7 @@ void updateGamelist(SystemData* system)
 		}
 	}else{
 		//set up an empty gamelist to append to
-		root = doc.append_child("gameList");
+		root = doc->append_child("gameList");
 	}
 
 	std::vector<FileData*> changedGames;
@@ -246,75 +550,60 @@ void updateGamelist(SystemData* system)
 	{
 		int numUpdated = 0;
 
-		std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME | FOLDER);
-
 		// Stage 1: iterate through all files in memory, checking for changes
-		for(std::vector<FileData*>::const_iterator fit = files.cbegin(); fit != files.cend(); ++fit)
+		rootFolder->visitFiles(GAME | FOLDER, [&changedGames, &changedFolders](FileData* file) -> bool
 		{
-
 			// do not touch if it wasn't changed anyway
-			if (!(*fit)->metadata.wasChanged())
-				continue;
+			if (!file->metadata.wasChanged())
+				return true;
 
 			// adding item to changed list
-			if ((*fit)->getType() == GAME)
+			if (file->getType() == GAME)
 			{
-				changedGames.push_back((*fit));
+				changedGames.push_back(file);
 			}
 			else
 			{
-				changedFolders.push_back((*fit));
+				changedFolders.push_back(file);
 			}
-		}
+			return true;
+		});
 
 
 		// Stage 2: iterate XML if needed, to remove and add changed items
 		const char* tagList[2] = { "game", "folder" };
-		FileType typeList[2] = { GAME, FOLDER };
-		std::vector<FileData*> changedList[2] = { changedGames, changedFolders };
+		std::vector<FileData*>* changedList[2] = { &changedGames, &changedFolders };
 
 		for(int i = 0; i < 2; i++)
 		{
 			const char* tag = tagList[i];
-			std::vector<FileData*> changes = changedList[i];
+			const std::vector<FileData*>& changes = *changedList[i];
 
 			// check for changed items of this type
 			if (changes.size() > 0) {
-				// check if the item already exists in the XML
-				// if it does, remove all corresponding items before adding
-				for(pugi::xml_node fileNode = root.child(tag); fileNode; )
+				// index the existing items by their resolved path, there can be more than one per path
+				std::unordered_multimap<std::string, pugi::xml_node> existing;
+				for(pugi::xml_node fileNode = root.child(tag); fileNode; fileNode = fileNode.next_sibling(tag))
 				{
 					pugi::xml_node pathNode = fileNode.child("path");
-
-					// we need this as we were deleting the iterator and things would become inconsistent
-					pugi::xml_node nextNode = fileNode.next_sibling(tag);
-
 					if(!pathNode)
 					{
 						LOG(LogError) << "<" << tag << "> node contains no <path> child!";
 						continue;
 					}
 
-					std::string xmlpath = pathNode.text().get();
 					// apply the same transformation as in Gamelist::parseGamelist
-					xmlpath = Utils::FileSystem::resolveRelativePath(xmlpath, relativeTo, false, true);
-
-					for(std::vector<FileData*>::const_iterator cfit = changes.cbegin(); cfit != changes.cend(); ++cfit)
-					{
-						if(xmlpath == (*cfit)->getPath())
-						{
-							// found it
-							root.remove_child(fileNode);
-							break;
-						}
-					}
-					fileNode = nextNode;
-
+					existing.insert(std::make_pair(Utils::FileSystem::resolveRelativePath(pathNode.text().get(), relativeTo, false, true), fileNode));
 				}
 
-				// add items to XML
 				for(std::vector<FileData*>::const_iterator cfit = changes.cbegin(); cfit != changes.cend(); ++cfit)
 				{
+					// if the item already exists in the XML, remove all corresponding items before adding
+					auto range = existing.equal_range((*cfit)->getPath());
+					for(auto it = range.first; it != range.second; ++it)
+						root.remove_child(it->second);
+					existing.erase(range.first, range.second);
+
 					// it was either removed or never existed to begin with; either way, we can add it now
 					addFileDataNode(root, *cfit, tag, system);
 					++numUpdated;
@@ -322,23 +611,19 @@ void updateGamelist(SystemData* system)
 			}
 		}
 
-		// now write the file
+		// now hand the file to the writer, it's serialized and saved in the background
 
 		if (numUpdated > 0) {
-			const auto startTs = std::chrono::system_clock::now();
-
 			//make sure the folders leading up to this path exist (or the write will fail)
-			std::string xmlWritePath(system->getGamelistPath(true));
 			Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(xmlWritePath));
 
 			LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
 
-			if (!doc.save_file(xmlWritePath.c_str())) {
-				LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
-			}
-
-			const auto endTs = std::chrono::system_clock::now();
-			LOG(LogInfo) << "Saved gamelist.xml for system \"" << system->getName() << "\" in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
+			queueGamelistWrite(xmlWritePath, doc, base, onWritten);
+		}
+		else if(onWritten && !whenGamelistWritten(xmlWritePath, onWritten))
+		{
+			onWritten(true);
 		}
 	}else{
 		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
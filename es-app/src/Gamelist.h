@@ -2,12 +2,43 @@
 #ifndef ES_APP_GAME_LIST_H
 #define ES_APP_GAME_LIST_H
 
+#include "utils/FileSystemUtil.h"
+#include "FileData.h"
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <time.h>
+#include <vector>
+
 class SystemData;
 
+// Finds the FileData for path in the tree of a SystemData, creating it (and the folders leading up to it) if needed.
+FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType type, bool* created = NULL);
+
 // Loads gamelist.xml data into a SystemData.
 void parseGamelist(SystemData* system);
 
-// Writes currently loaded metadata for a SystemData to gamelist.xml.
-void updateGamelist(SystemData* system);
+// Loads gamelist.xml data into an already loaded SystemData, i.e. after it was changed outside of ES.
+// Games which were added to the tree are indexed and returned in added, files whose metadata changed
+// are re-indexed and returned in changed. Metadata with unsaved changes is left alone.
+void mergeGamelist(SystemData* system, std::vector<FileData*>& added, std::vector<FileData*>& changed);
+
+// Told on a writer thread whether a gamelist made it to disk.
+typedef std::function<void(bool written)> GamelistWrittenCallback;
+
+// Writes currently loaded metadata for a SystemData to gamelist.xml. The file is written in the background
+// and replaced atomically, a crash leaves either the old or the new version behind. onWritten is called
+// once everything loaded is on disk, it isn't called at all if the gamelist can't be read.
+void updateGamelist(SystemData* system, const GamelistWrittenCallback& onWritten = nullptr);
+
+// The stamp the gamelist.xml at path got when ES last wrote it, all 0 if it didn't. A file with any other stamp
+// than this or the one it had when it was read was changed by someone else.
+Utils::FileSystem::FileStamp getWrittenGamelistStamp(const std::string& path);
+
+// Waits until all gamelists handed to the background writer are on disk.
+void flushGamelistWrites();
+
+// Bytes of gamelist.xml the background writer put on disk so far.
+uint64_t getGamelistBytesWritten();
 
 #endif // ES_APP_GAME_LIST_H
@@ -0,0 +1,495 @@
+#include "GamelistCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/TraceUtil.h"
+#include "FileData.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+// Layout of a snapshot (all values in native byte order, strings are prefixed by their uint32 length):
+//   header:  magic, version, settings flags, start path, extensions, gamelist path, gamelist stamp
+//   folders: count, then path and stamp of every folder read by SystemData::populateFolder()
+//   keys:    count, then the metadata keys referenced by index from the nodes
+//   nodes:   count, then type, node flags, parent index, path and non-default metadata of every
+//            FileData in pre-order, the first node being the root folder
+// A stamp is the modification time in nanoseconds, size and inode, so a change within the second the snapshot
+// was taken in isn't missed. Bump CACHE_VERSION whenever this layout changes, older snapshots are then simply ignored.
+
+static const char     CACHE_MAGIC[4]  = { 'E', 'S', 'G', 'C' };
+static const uint32_t CACHE_VERSION   = 2;
+static const uint32_t NO_PARENT       = 0xFFFFFFFF;
+
+// settings which change the shape of the tree
+static const uint32_t FLAG_PARSE_GAMELIST_ONLY = 1 << 0;
+static const uint32_t FLAG_IGNORE_GAMELIST     = 1 << 1;
+static const uint32_t FLAG_SHOW_HIDDEN_FILES   = 1 << 2;
+
+// per node flags
+static const uint8_t NODE_CHANGED       = 1 << 0; // metadata differs from what is in gamelist.xml
+static const uint8_t NODE_ABSOLUTE_PATH = 1 << 1; // path is not below the system start path
+
+class CacheFile
+{
+public:
+	CacheFile(const std::string& path) : mData(NULL), mSize(0), mMapped(false)
+	{
+#if !defined(_WIN32)
+		int fd = open(path.c_str(), O_RDONLY);
+		if(fd < 0)
+			return;
+
+		struct stat info;
+		if(fstat(fd, &info) == 0 && info.st_size > 0)
+		{
+			void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(map != MAP_FAILED)
+			{
+				mData = (const char*)map;
+				mSize = (size_t)info.st_size;
+				mMapped = true;
+			}
+		}
+		close(fd);
+
+		if(mMapped)
+			return;
+#endif // !_WIN32
+
+		// no mmap available, read the whole snapshot instead
+		std::ifstream stream(path.c_str(), std::ios::binary);
+		if(!stream)
+			return;
+
+		mBuffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		mData = mBuffer.data();
+		mSize = mBuffer.size();
+	}
+
+	~CacheFile()
+	{
+#if !defined(_WIN32)
+		if(mMapped)
+			munmap((void*)mData, mSize);
+#endif // !_WIN32
+	}
+
+	inline const char* data() const { return mData; }
+	inline size_t size() const { return mSize; }
+
+private:
+	const char* mData;
+	size_t mSize;
+	bool mMapped;
+	std::string mBuffer;
+};
+
+class CacheReader
+{
+public:
+	CacheReader(const char* data, size_t size) : mCur(data), mEnd(data + size), mOk(data != NULL) {}
+
+	template<typename T> T read()
+	{
+		T value = T();
+		if(!mOk || (size_t)(mEnd - mCur) < sizeof(T))
+		{
+			mOk = false;
+			return value;
+		}
+
+		memcpy(&value, mCur, sizeof(T));
+		mCur += sizeof(T);
+		return value;
+	}
+
+	std::string readString()
+	{
+		const uint32_t length = read<uint32_t>();
+		if(!mOk || (size_t)(mEnd - mCur) < length)
+		{
+			mOk = false;
+			return std::string();
+		}
+
+		std::string value(mCur, length);
+		mCur += length;
+		return value;
+	}
+
+	void skipString()
+	{
+		const uint32_t length = read<uint32_t>();
+		if(!mOk || (size_t)(mEnd - mCur) < length)
+			mOk = false;
+		else
+			mCur += length;
+	}
+
+	Utils::FileSystem::FileStamp readStamp()
+	{
+		Utils::FileSystem::FileStamp stamp;
+		stamp.modTime = read<int64_t>();
+		stamp.size    = read<int64_t>();
+		stamp.inode   = read<uint64_t>();
+		return stamp;
+	}
+
+	inline const char* position() const { return mCur; }
+	inline void setPosition(const char* position) { mCur = position; }
+	inline void fail() { mOk = false; }
+	inline bool ok() const { return mOk; }
+
+private:
+	const char* mCur;
+	const char* mEnd;
+	bool mOk;
+};
+
+class CacheWriter
+{
+public:
+	template<typename T> void write(const T& value) { mBuffer.append((const char*)&value, sizeof(T)); }
+
+	void writeString(const std::string& value)
+	{
+		write<uint32_t>((uint32_t)value.size());
+		mBuffer.append(value);
+	}
+
+	void writeStamp(const Utils::FileSystem::FileStamp& stamp)
+	{
+		write<int64_t>(stamp.modTime);
+		write<int64_t>(stamp.size);
+		write<uint64_t>(stamp.inode);
+	}
+
+	inline const std::string& buffer() const { return mBuffer; }
+
+private:
+	std::string mBuffer;
+};
+
+static std::string getCachePath(SystemData* system)
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/cache/" + system->getName() + ".bin";
+}
+
+static uint32_t getSettingsFlags()
+{
+	uint32_t flags = 0;
+
+	if(Settings::getInstance()->getBool("ParseGamelistOnly"))
+		flags |= FLAG_PARSE_GAMELIST_ONLY;
+	if(Settings::getInstance()->getBool("IgnoreGamelist"))
+		flags |= FLAG_IGNORE_GAMELIST;
+	if(Settings::getInstance()->getBool("ShowHiddenFiles"))
+		flags |= FLAG_SHOW_HIDDEN_FILES;
+
+	return flags;
+}
+
+static std::string getExtensionList(SystemData* system)
+{
+	std::string list;
+
+	for(auto it = system->getExtensions().cbegin(); it != system->getExtensions().cend(); ++it)
+		list += *it + " ";
+
+	return list;
+}
+
+static void writeNode(CacheWriter& writer, FileData* file, uint32_t parent, uint32_t& index, const std::string& startPath, const std::vector<std::string>& keys)
+{
+	const uint32_t self = index++;
+	const std::string& path = file->getPath();
+
+	uint8_t flags = file->metadata.wasChanged() ? NODE_CHANGED : 0;
+	std::string relative;
+
+	if(parent != NO_PARENT)
+	{
+		if(path.size() > startPath.size() && path.compare(0, startPath.size(), startPath) == 0 && path[startPath.size()] == '/')
+			relative = path.substr(startPath.size() + 1);
+		else
+		{
+			flags |= NODE_ABSOLUTE_PATH;
+			relative = path;
+		}
+	}
+
+	writer.write<uint8_t>((uint8_t)file->getType());
+	writer.write<uint8_t>(flags);
+	writer.write<uint32_t>(parent);
+	writer.writeString(relative);
+
+	// only store what differs from the declared defaults, the name is always stored
+	const std::vector<MetaDataDecl>& mdd = file->metadata.getMDD();
+	std::vector<std::pair<uint8_t, const std::string*>> values;
+
+	for(auto it = mdd.cbegin(); it != mdd.cend(); ++it)
+	{
+		const std::string& value = file->metadata.get(it->id);
+		if(it->id != META_NAME && value == it->defaultValue)
+			continue;
+
+		const uint8_t keyIndex = (uint8_t)(std::find(keys.cbegin(), keys.cend(), it->key) - keys.cbegin());
+		values.push_back(std::make_pair(keyIndex, &value));
+	}
+
+	writer.write<uint8_t>((uint8_t)values.size());
+	for(auto it = values.cbegin(); it != values.cend(); ++it)
+	{
+		writer.write<uint8_t>(it->first);
+		writer.writeString(*it->second);
+	}
+
+	const std::vector<FileData*>& children = file->getChildren();
+	for(auto it = children.cbegin(); it != children.cend(); ++it)
+		writeNode(writer, *it, self, index, startPath, keys);
+}
+
+static uint32_t countNodes(FileData* file)
+{
+	uint32_t count = 1;
+
+	const std::vector<FileData*>& children = file->getChildren();
+	for(auto it = children.cbegin(); it != children.cend(); ++it)
+		count += countNodes(*it);
+
+	return count;
+}
+
+bool loadGamelistCache(SystemData* system)
+{
+	TraceScopeDetail("loadGamelistCache", system->getName());
+
+	const auto startTs = std::chrono::system_clock::now();
+	const std::string cachePath = getCachePath(system);
+
+	CacheFile file(cachePath);
+	if(file.data() == NULL)
+		return false;
+
+	CacheReader reader(file.data(), file.size());
+
+	// header
+	char magic[4];
+	for(int i = 0; i < 4; i++)
+		magic[i] = reader.read<char>();
+
+	if(!reader.ok() || memcmp(magic, CACHE_MAGIC, 4) != 0 || reader.read<uint32_t>() != CACHE_VERSION)
+	{
+		LOG(LogInfo) << "Gamelist cache \"" << cachePath << "\" has an unknown format, ignoring it";
+		return false;
+	}
+
+	const uint32_t flags = reader.read<uint32_t>();
+	if(flags != getSettingsFlags() || reader.readString() != system->getStartPath() || reader.readString() != getExtensionList(system))
+		return false;
+
+	const std::string gamelistPath = reader.readString();
+	const Utils::FileSystem::FileStamp gamelistStamp = reader.readStamp();
+	if(!(flags & FLAG_IGNORE_GAMELIST) && (gamelistPath != system->getGamelistPath(false) || gamelistStamp != Utils::FileSystem::getFileStamp(gamelistPath)))
+	{
+		LOG(LogInfo) << "Gamelist cache for system \"" << system->getName() << "\" is outdated (gamelist changed)";
+		return false;
+	}
+
+	// every folder that was read when the snapshot was taken must be untouched since then
+	std::vector<std::pair<std::string, Utils::FileSystem::FileStamp>> folders;
+	const uint32_t folderCount = reader.read<uint32_t>();
+	for(uint32_t i = 0; i < folderCount && reader.ok(); i++)
+	{
+		std::string path = reader.readString();
+		const Utils::FileSystem::FileStamp folderStamp = reader.readStamp();
+
+		if(reader.ok() && folderStamp != Utils::FileSystem::getFileStamp(path))
+		{
+			LOG(LogInfo) << "Gamelist cache for system \"" << system->getName() << "\" is outdated (\"" << path << "\" changed)";
+			return false;
+		}
+
+		folders.push_back(std::make_pair(path, folderStamp));
+	}
+
+	// keys are stored by name, so a snapshot stays readable when the declarations are reordered
+	std::vector<MetaDataId> keys;
+	const uint32_t keyCount = reader.read<uint32_t>();
+	for(uint32_t i = 0; i < keyCount && reader.ok(); i++)
+		keys.push_back(MetaDataList::getId(reader.readString()));
+
+	// first pass: make sure the node table is complete before touching the tree
+	const uint32_t nodeCount = reader.read<uint32_t>();
+	const char* nodesStart = reader.position();
+	std::vector<uint8_t> types;
+	for(uint32_t i = 0; i < nodeCount && reader.ok(); i++)
+	{
+		const uint8_t type = reader.read<uint8_t>();
+		reader.read<uint8_t>();
+		const uint32_t parent = reader.read<uint32_t>();
+		reader.skipString();
+		types.push_back(type);
+
+		if((type != GAME && type != FOLDER) || (i == 0 ? (parent != NO_PARENT || type != FOLDER) : (parent >= i || types[parent] != FOLDER)))
+		{
+			reader.fail();
+			break;
+		}
+
+		const uint8_t valueCount = reader.read<uint8_t>();
+		for(uint8_t j = 0; j < valueCount && reader.ok(); j++)
+		{
+			if(reader.read<uint8_t>() >= keyCount)
+			{
+				reader.fail();
+				break;
+			}
+			reader.skipString();
+		}
+	}
+
+	if(!reader.ok() || nodeCount == 0)
+	{
+		LOG(LogWarning) << "Gamelist cache \"" << cachePath << "\" is corrupt, ignoring it";
+		return false;
+	}
+
+	// second pass: rebuild the tree
+	const std::string& startPath = system->getStartPath();
+	std::vector<FileData*> nodes;
+	nodes.reserve(nodeCount);
+	reader.setPosition(nodesStart);
+
+	for(uint32_t i = 0; i < nodeCount; i++)
+	{
+		const FileType type = (FileType)reader.read<uint8_t>();
+		const uint8_t nodeFlags = reader.read<uint8_t>();
+		const uint32_t parent = reader.read<uint32_t>();
+		const std::string path = reader.readString();
+
+		FileData* node;
+		if(parent == NO_PARENT)
+			node = system->getRootFolder();
+		else
+		{
+			node = new (system->getArena()) FileData(type, (nodeFlags & NODE_ABSOLUTE_PATH) ? path : startPath + "/" + path, system->getSystemEnvData(), system);
+			nodes[parent]->addChild(node);
+		}
+
+		const uint8_t valueCount = reader.read<uint8_t>();
+		for(uint8_t j = 0; j < valueCount; j++)
+		{
+			const uint8_t     key   = reader.read<uint8_t>();
+			const std::string value = reader.readString();
+			if(key < keys.size() && keys[key] != META_COUNT)
+				node->metadata.set(keys[key], value);
+		}
+
+		if(!(nodeFlags & NODE_CHANGED))
+			node->metadata.resetChangedFlag();
+
+		nodes.push_back(node);
+	}
+
+	system->setScannedFolders(folders);
+
+	const auto endTs = std::chrono::system_clock::now();
+	LOG(LogInfo) << "Loaded " << nodeCount << " entries for system \"" << system->getName() << "\" from gamelist cache in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
+
+	return true;
+}
+
+void saveGamelistCache(SystemData* system)
+{
+	TraceScopeDetail("saveGamelistCache", system->getName());
+
+	FileData* rootFolder = system->getRootFolder();
+	if(rootFolder == nullptr)
+		return;
+
+	const uint32_t flags = getSettingsFlags();
+	const std::string gamelistPath = system->getGamelistPath(false);
+
+	CacheWriter writer;
+	for(int i = 0; i < 4; i++)
+		writer.write<char>(CACHE_MAGIC[i]);
+	writer.write<uint32_t>(CACHE_VERSION);
+	writer.write<uint32_t>(flags);
+	writer.writeString(system->getStartPath());
+	writer.writeString(getExtensionList(system));
+	writer.writeString(gamelistPath);
+	// the version the tree was read from (or we wrote), a change made since invalidates the snapshot
+	writer.writeStamp((flags & FLAG_IGNORE_GAMELIST) ? Utils::FileSystem::FileStamp() : system->getGamelistStamp());
+
+	const std::vector<std::pair<std::string, Utils::FileSystem::FileStamp>>& folders = system->getScannedFolders();
+	writer.write<uint32_t>((uint32_t)folders.size());
+	for(auto it = folders.cbegin(); it != folders.cend(); ++it)
+	{
+		writer.writeString(it->first);
+		writer.writeStamp(it->second);
+	}
+
+	// games and folders use different declarations, store the union of both
+	std::vector<std::string> keys;
+	const MetaDataListType types[2] = { GAME_METADATA, FOLDER_METADATA };
+	for(int i = 0; i < 2; i++)
+	{
+		const std::vector<MetaDataDecl>& mdd = getMDDByType(types[i]);
+		for(auto it = mdd.cbegin(); it != mdd.cend(); ++it)
+		{
+			if(std::find(keys.cbegin(), keys.cend(), it->key) == keys.cend())
+				keys.push_back(it->key);
+		}
+	}
+
+	writer.write<uint32_t>((uint32_t)keys.size());
+	for(auto it = keys.cbegin(); it != keys.cend(); ++it)
+		writer.writeString(*it);
+
+	uint32_t index = 0;
+	writer.write<uint32_t>(countNodes(rootFolder));
+	writeNode(writer, rootFolder, NO_PARENT, index, system->getStartPath(), keys);
+
+	// write to a temporary file first so a crash never leaves a half written snapshot behind
+	const std::string cachePath = getCachePath(system);
+	const std::string tempPath = cachePath + ".tmp";
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(cachePath));
+
+	std::ofstream stream(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+	stream.write(writer.buffer().data(), writer.buffer().size());
+	stream.close();
+
+	if(stream.fail())
+	{
+		LOG(LogWarning) << "Could not write gamelist cache \"" << tempPath << "\"";
+		Utils::FileSystem::removeFile(tempPath);
+		return;
+	}
+
+#if defined(_WIN32)
+	remove(cachePath.c_str());
+#endif // _WIN32
+	if(rename(tempPath.c_str(), cachePath.c_str()) != 0)
+	{
+		LOG(LogWarning) << "Could not replace gamelist cache \"" << cachePath << "\"";
+		Utils::FileSystem::removeFile(tempPath);
+		return;
+	}
+
+	LOG(LogDebug) << "Saved gamelist cache for system \"" << system->getName() << "\" (" << index << " entries, " << writer.buffer().size() << " bytes)";
+}
@@ -0,0 +1,15 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_CACHE_H
+#define ES_APP_GAMELIST_CACHE_H
+
+class SystemData;
+
+// Loads the binary snapshot of a system's FileData tree into its (still empty) root folder.
+// Returns false if there is no snapshot or it no longer matches gamelist.xml and the rom folders,
+// in which case the caller has to fall back to scanning the folders and parsing gamelist.xml.
+bool loadGamelistCache(SystemData* system);
+
+// Writes the binary snapshot for the currently loaded FileData tree of a SystemData.
+void saveGamelistCache(SystemData* system);
+
+#endif // ES_APP_GAMELIST_CACHE_H
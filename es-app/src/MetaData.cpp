@@ -3,28 +3,30 @@
 #include "utils/FileSystemUtil.h"
 #include "utils/TimeUtil.h"
 #include "Log.h"
+#include <atomic>
 #include <pugixml.hpp>
+#include <unordered_map>
 
 MetaDataDecl gameDecls[] = {
-	// key,         type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
-	{"name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-	{"sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
-	{"desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{"image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{"video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
-	{"marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{"thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{"rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
-	{"releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
-	{"developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
-	{"publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
-	{"genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
-	{"players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
-	{"favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
-	{"hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
-	{"kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
-	{"playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
-	{"lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
+	// id,              key,          type,                   default,            statistic,  name in GuiMetaDataEd,  prompt in GuiMetaDataEd
+	{META_NAME,        "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+	{META_SORTNAME,    "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
+	{META_DESC,        "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{META_IMAGE,       "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{META_VIDEO,       "video",       MD_PATH     ,           "",                 false,      "video",                "enter path to video"},
+	{META_MARQUEE,     "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{META_THUMBNAIL,   "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{META_RATING,      "rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
+	{META_RELEASEDATE, "releasedate", MD_DATE,                "not-a-date-time",  false,      "release date",         "enter release date"},
+	{META_DEVELOPER,   "developer",   MD_STRING,              "unknown",          false,      "developer",            "enter game developer"},
+	{META_PUBLISHER,   "publisher",   MD_STRING,              "unknown",          false,      "publisher",            "enter game publisher"},
+	{META_GENRE,       "genre",       MD_STRING,              "unknown",          false,      "genre",                "enter game genre"},
+	{META_PLAYERS,     "players",     MD_INT,                 "1",                false,      "players",              "enter number of players"},
+	{META_FAVORITE,    "favorite",    MD_BOOL,                "false",            false,      "favorite",             "enter favorite off/on"},
+	{META_HIDDEN,      "hidden",      MD_BOOL,                "false",            false,      "hidden",               "enter hidden off/on" },
+	{META_KIDGAME,     "kidgame",     MD_BOOL,                "false",            false,      "kidgame",              "enter kidgame off/on" },
+	{META_PLAYCOUNT,   "playcount",   MD_INT,                 "0",                true,       "play count",           "enter number of times played"},
+	{META_LASTPLAYED,  "lastplayed",  MD_TIME,                "0",                true,       "last played",          "enter last played date"}
 };
 const std::vector<MetaDataDecl> gameMDD(gameDecls, gameDecls + sizeof(gameDecls) / sizeof(gameDecls[0]));
 
@@ -35,19 +37,19 @@ const inline std::string blankDate() {
 }
 
 MetaDataDecl folderDecls[] = {
-	{"name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
-	{"sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
-	{"desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
-	{"image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
-	{"thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
-	{"video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
-	{"marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
-	{"rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
-	{"releasedate", MD_DATE,                blankDate(),        true,       "release date",         "enter release date"},
-	{"developer",   MD_STRING,              "",                 false,      "developer",            "enter game developer"},
-	{"publisher",   MD_STRING,              "",                 false,      "publisher",            "enter game publisher"},
-	{"genre",       MD_STRING,              "",                 false,      "genre",                "enter game genre"},
-	{"players",     MD_INT,                 "",                 false,      "players",              "enter number of players"}
+	{META_NAME,        "name",        MD_STRING,              "",                 false,      "name",                 "enter game name"},
+	{META_SORTNAME,    "sortname",    MD_STRING,              "",                 false,      "sortname",             "enter game sort name"},
+	{META_DESC,        "desc",        MD_MULTILINE_STRING,    "",                 false,      "description",          "enter description"},
+	{META_IMAGE,       "image",       MD_PATH,                "",                 false,      "image",                "enter path to image"},
+	{META_THUMBNAIL,   "thumbnail",   MD_PATH,                "",                 false,      "thumbnail",            "enter path to thumbnail"},
+	{META_VIDEO,       "video",       MD_PATH,                "",                 false,      "video",                "enter path to video"},
+	{META_MARQUEE,     "marquee",     MD_PATH,                "",                 false,      "marquee",              "enter path to marquee"},
+	{META_RATING,      "rating",      MD_RATING,              "0",                false,      "rating",               "enter rating"},
+	{META_RELEASEDATE, "releasedate", MD_DATE,                blankDate(),        true,       "release date",         "enter release date"},
+	{META_DEVELOPER,   "developer",   MD_STRING,              "",                 false,      "developer",            "enter game developer"},
+	{META_PUBLISHER,   "publisher",   MD_STRING,              "",                 false,      "publisher",            "enter game publisher"},
+	{META_GENRE,       "genre",       MD_STRING,              "",                 false,      "genre",                "enter game genre"},
+	{META_PLAYERS,     "players",     MD_INT,                 "",                 false,      "players",              "enter number of players"}
 };
 const std::vector<MetaDataDecl> folderMDD(folderDecls, folderDecls + sizeof(folderDecls) / sizeof(folderDecls[0]));
 
@@ -68,11 +70,26 @@ const std::vector<MetaDataDecl>& getMDDByType(MetaDataListType type)
 
 
 MetaDataList::MetaDataList(MetaDataListType type)
-	: mType(type), mWasChanged(false)
+	: mType(type), mRating(0), mPlayers(0), mPlayCount(0), mLastPlayed(0), mWasChanged(false), mChangeStamp(0), mNameKeyGeneration(0)
 {
 	const std::vector<MetaDataDecl>& mdd = getMDD();
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
-		set(iter->key, iter->defaultValue);
+		set(iter->id, iter->defaultValue);
+}
+
+MetaDataId MetaDataList::getId(const std::string& key)
+{
+	static const std::unordered_map<std::string, MetaDataId> ids = []
+	{
+		// the game declarations have every key
+		std::unordered_map<std::string, MetaDataId> keys;
+		for(auto iter = gameMDD.cbegin(); iter != gameMDD.cend(); iter++)
+			keys[iter->key] = iter->id;
+		return keys;
+	}();
+
+	auto it = ids.find(key);
+	return (it != ids.cend()) ? it->second : META_COUNT;
 }
 
 
@@ -85,7 +102,8 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 	for(auto iter = mdd.cbegin(); iter != mdd.cend(); iter++)
 	{
 		pugi::xml_node md = node.child(iter->key.c_str());
-		if(md)
+		// an empty flag (i.e. <hidden/>) is no valid value, it keeps the default like a missing one
+		if(md && !(iter->type == MD_BOOL && md.text().empty()))
 		{
 			// if it's a path, resolve relative paths
 			std::string value = md.text().get();
@@ -93,9 +111,7 @@ MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node&
 			{
 				value = Utils::FileSystem::resolveRelativePath(value, relativeTo, true, true);
 			}
-			mdl.set(iter->key, value);
-		}else{
-			mdl.set(iter->key, iter->defaultValue);
+			mdl.set(iter->id, value);
 		}
 	}
 
@@ -108,43 +124,126 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 
 	for(auto mddIter = mdd.cbegin(); mddIter != mdd.cend(); mddIter++)
 	{
-		auto mapIter = mMap.find(mddIter->key);
-		if(mapIter != mMap.cend())
-		{
-			// we have this value!
-			// if it's just the default (and we ignore defaults), don't write it
-			if(ignoreDefaults && mapIter->second == mddIter->defaultValue)
-				continue;
+		const std::string& value = mValues[mddIter->id];
 
-			// try and make paths relative if we can
-			std::string value = mapIter->second;
-			if (mddIter->type == MD_PATH)
-				value = Utils::FileSystem::createRelativePath(value, relativeTo, true, true);
+		// if it's just the default (and we ignore defaults), don't write it
+		if(ignoreDefaults && value == mddIter->defaultValue)
+			continue;
 
-			parent.append_child(mapIter->first.c_str()).text().set(value.c_str());
-		}
+		// try and make paths relative if we can
+		if (mddIter->type == MD_PATH)
+			parent.append_child(mddIter->key.c_str()).text().set(Utils::FileSystem::createRelativePath(value, relativeTo, true, true).c_str());
+		else
+			parent.append_child(mddIter->key.c_str()).text().set(value.c_str());
 	}
 }
 
-void MetaDataList::set(const std::string& key, const std::string& value)
+// the loader threads set metadata concurrently, each takes a block of stamps at a time instead of sharing one counter
+static unsigned int nextChangeStamp()
 {
-	mMap[key] = value;
+	static const unsigned int BLOCK_SIZE = 4096;
+	static std::atomic<unsigned int> nextBlock(0);
+	static thread_local unsigned int current = 0;
+	static thread_local unsigned int end = 0;
+
+	if(current == end)
+	{
+		current = nextBlock.fetch_add(BLOCK_SIZE);
+		end = current + BLOCK_SIZE;
+		if(current == 0) // 0 is never handed out
+			current++;
+	}
+
+	return current++;
+}
+
+void MetaDataList::set(MetaDataId id, const std::string& value)
+{
+	mValues[id] = value;
+
+	switch(id)
+	{
+		case META_RATING:     mRating    = (float)atof(value.c_str()); break;
+		case META_PLAYERS:    mPlayers   = atoi(value.c_str());        break;
+		case META_PLAYCOUNT:  mPlayCount = atoi(value.c_str());        break;
+		case META_LASTPLAYED:
+			// most games were never played, "0" doesn't need a parse
+			mLastPlayed = (value.empty() || value == "0") ? 0 : Utils::Time::stringToTime(value);
+			break;
+		case META_NAME:
+		case META_SORTNAME:
+			mNameKeyGeneration = 0;
+			break;
+		default:
+			break;
+	}
+
 	mWasChanged = true;
+	mChangeStamp = nextChangeStamp();
+}
+
+void MetaDataList::set(const std::string& key, const std::string& value)
+{
+	const MetaDataId id = getId(key);
+	if(id == META_COUNT)
+	{
+		LOG(LogError) << "Unknown metadata key \"" << key << "\"";
+		return;
+	}
+
+	set(id, value);
 }
 
 const std::string& MetaDataList::get(const std::string& key) const
 {
-	return mMap.at(key);
+	static const std::string empty;
+
+	const MetaDataId id = getId(key);
+	if(id == META_COUNT)
+	{
+		LOG(LogError) << "Unknown metadata key \"" << key << "\"";
+		return empty;
+	}
+
+	return mValues[id];
+}
+
+int MetaDataList::getInt(MetaDataId id) const
+{
+	switch(id)
+	{
+		case META_PLAYERS:   return mPlayers;
+		case META_PLAYCOUNT: return mPlayCount;
+		default:             return atoi(mValues[id].c_str());
+	}
 }
 
 int MetaDataList::getInt(const std::string& key) const
 {
-	return atoi(get(key).c_str());
+	const MetaDataId id = getId(key);
+	return (id != META_COUNT) ? getInt(id) : atoi(get(key).c_str());
+}
+
+float MetaDataList::getFloat(MetaDataId id) const
+{
+	if(id == META_RATING)
+		return mRating;
+
+	return (float)atof(mValues[id].c_str());
 }
 
 float MetaDataList::getFloat(const std::string& key) const
 {
-	return (float)atof(get(key).c_str());
+	const MetaDataId id = getId(key);
+	return (id != META_COUNT) ? getFloat(id) : (float)atof(get(key).c_str());
+}
+
+time_t MetaDataList::getTime(MetaDataId id) const
+{
+	if(id == META_LASTPLAYED)
+		return mLastPlayed;
+
+	return Utils::Time::stringToTime(mValues[id]);
 }
 
 bool MetaDataList::wasChanged() const
@@ -156,3 +255,17 @@ void MetaDataList::resetChangedFlag()
 {
 	mWasChanged = false;
 }
+
+bool MetaDataList::operator==(const MetaDataList& other) const
+{
+	if(mType != other.mType)
+		return false;
+
+	for(int i = 0; i < META_COUNT; i++)
+	{
+		if(mValues[i] != other.mValues[i])
+			return false;
+	}
+
+	return true;
+}
@@ -2,7 +2,7 @@
 #ifndef ES_APP_META_DATA_H
 #define ES_APP_META_DATA_H
 
-#include <map>
+#include <time.h>
 #include <vector>
 #include <string>
 
@@ -24,8 +24,34 @@ enum MetaDataType
 	MD_TIME //used for lastplayed
 };
 
+// Every key a MetaDataDecl can have, indexes the value slots of a MetaDataList.
+enum MetaDataId
+{
+	META_NAME,
+	META_SORTNAME,
+	META_DESC,
+	META_IMAGE,
+	META_VIDEO,
+	META_MARQUEE,
+	META_THUMBNAIL,
+	META_RATING,
+	META_RELEASEDATE,
+	META_DEVELOPER,
+	META_PUBLISHER,
+	META_GENRE,
+	META_PLAYERS,
+	META_FAVORITE,
+	META_HIDDEN,
+	META_KIDGAME,
+	META_PLAYCOUNT,
+	META_LASTPLAYED,
+
+	META_COUNT
+};
+
 struct MetaDataDecl
 {
+	MetaDataId id;
 	std::string key;
 	MetaDataType type;
 	std::string defaultValue;
@@ -50,22 +76,50 @@ public:
 
 	MetaDataList(MetaDataListType type);
 
+	void set(MetaDataId id, const std::string& value);
 	void set(const std::string& key, const std::string& value);
 
+	inline const std::string& get(MetaDataId id) const { return mValues[id]; }
 	const std::string& get(const std::string& key) const;
+	int getInt(MetaDataId id) const;
 	int getInt(const std::string& key) const;
+	float getFloat(MetaDataId id) const;
 	float getFloat(const std::string& key) const;
+	time_t getTime(MetaDataId id) const;
+
+	// META_COUNT if the key isn't declared for any type
+	static MetaDataId getId(const std::string& key);
 
 	bool wasChanged() const;
 	void resetChangedFlag();
 
+	// Every set() gives the list a new process wide unique stamp (never 0), so anyone holding on to a stamp can tell
+	// whether the values changed since, even across copies of the list.
+	inline unsigned int getChangeStamp() const { return mChangeStamp; }
+
+	// compares the values only, not whether they were changed
+	bool operator==(const MetaDataList& other) const;
+
 	inline MetaDataListType getType() const { return mType; }
 	inline const std::vector<MetaDataDecl>& getMDD() const { return getMDDByType(getType()); }
 
+	// A key derived from name and sortname (the normalized sort name of FileSorts), dropped whenever either of them
+	// is set. The key is only valid for the generation it was stored with, which lets its owner drop all of them at once.
+	inline const std::string* getNameKey(unsigned int generation) const { return (mNameKeyGeneration == generation) ? &mNameKey : NULL; }
+	inline const std::string& setNameKey(unsigned int generation, const std::string& key) const { mNameKey = key; mNameKeyGeneration = generation; return mNameKey; }
+
 private:
 	MetaDataListType mType;
-	std::map<std::string, std::string> mMap;
+	// the text is what gets saved, so it's kept as is and the numbers are parsed from it once when set
+	std::string mValues[META_COUNT];
+	float mRating;
+	int mPlayers;
+	int mPlayCount;
+	time_t mLastPlayed;
 	bool mWasChanged;
+	unsigned int mChangeStamp;
+	mutable std::string mNameKey;
+	mutable unsigned int mNameKeyGeneration; // 0 = no key
 };
 
 #endif // ES_APP_META_DATA_H
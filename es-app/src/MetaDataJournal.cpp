@@ -0,0 +1,292 @@
+#include "MetaDataJournal.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/TraceUtil.h"
+#include "FileData.h"
+#include "Log.h"
+#include "SystemData.h"
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <unordered_map>
+
+#if defined(_WIN32)
+#include <io.h>
+#else // _WIN32
+#include <unistd.h>
+#endif // _WIN32
+
+// Every line is "<path>\t<key>\t<value>\n", the path relative to the rom folder like in gamelist.xml.
+// Backslashes, tabs and newlines in the fields are escaped, a line without its newline was cut off by a crash
+// and is dropped from the file when the journal is replayed.
+
+struct Journal
+{
+	Journal() : file(NULL), size(0) { }
+
+	FILE*  file; // opened for appending on first use
+	size_t size; // bytes on disk
+};
+
+static std::mutex                     sJournalMutex;
+static std::map<std::string, Journal> sJournals; // by system name
+
+static std::string getJournalPath(const std::string& systemName)
+{
+	return Utils::FileSystem::getHomePath() + "/.emulationstation/journal/" + systemName + ".log";
+}
+
+static bool syncFile(FILE* file)
+{
+	if(fflush(file) != 0)
+		return false;
+
+#if defined(_WIN32)
+	return _commit(_fileno(file)) == 0;
+#elif defined(__APPLE__)
+	return fsync(fileno(file)) == 0;
+#else
+	// only the data and the size have to be on disk, not the rest of the file's metadata
+	return fdatasync(fileno(file)) == 0;
+#endif
+}
+
+static bool truncateFile(const std::string& path, size_t size)
+{
+#if defined(_WIN32)
+	FILE* file = fopen(path.c_str(), "r+b");
+	if(file == NULL)
+		return false;
+
+	const bool ok = _chsize_s(_fileno(file), (__int64)size) == 0;
+	return (fclose(file) == 0) && ok;
+#else
+	return truncate(path.c_str(), (off_t)size) == 0;
+#endif
+}
+
+static void appendEscaped(std::string& line, const std::string& text)
+{
+	for(auto it = text.cbegin(); it != text.cend(); ++it)
+	{
+		switch(*it)
+		{
+			case '\\': line += "\\\\"; break;
+			case '\t': line += "\\t";  break;
+			case '\n': line += "\\n";  break;
+			default:   line += *it;    break;
+		}
+	}
+}
+
+static std::string unescape(const std::string& text, size_t start, size_t end)
+{
+	std::string result;
+	result.reserve(end - start);
+
+	for(size_t i = start; i < end; i++)
+	{
+		if(text[i] == '\\' && i + 1 < end)
+		{
+			const char c = text[++i];
+			result += (c == 't') ? '\t' : (c == 'n') ? '\n' : c;
+		}
+		else
+		{
+			result += text[i];
+		}
+	}
+
+	return result;
+}
+
+void appendMetaDataJournal(FileData* file, const std::vector<MetaDataId>& ids)
+{
+	FileData*   source = file->getSourceFileData();
+	SystemData* system = source->getSystem();
+
+	std::string path;
+	appendEscaped(path, Utils::FileSystem::createRelativePath(source->getPath(), system->getStartPath(), false, true));
+
+	std::string lines;
+	const std::vector<MetaDataDecl>& mdd = source->metadata.getMDD();
+	for(auto id = ids.cbegin(); id != ids.cend(); ++id)
+	{
+		for(auto decl = mdd.cbegin(); decl != mdd.cend(); ++decl)
+		{
+			if(decl->id != *id)
+				continue;
+
+			lines += path;
+			lines += '\t';
+			appendEscaped(lines, decl->key);
+			lines += '\t';
+			appendEscaped(lines, source->metadata.get(*id));
+			lines += '\n';
+			break;
+		}
+	}
+
+	if(lines.empty())
+		return;
+
+	std::unique_lock<std::mutex> lock(sJournalMutex);
+
+	Journal&          journal     = sJournals[system->getName()];
+	const std::string journalPath = getJournalPath(system->getName());
+
+	if(journal.file == NULL)
+	{
+		Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(journalPath));
+
+		journal.file = fopen(journalPath.c_str(), "ab");
+		if(journal.file == NULL)
+		{
+			LOG(LogError) << "Could not open metadata journal \"" << journalPath << "\"";
+			return;
+		}
+	}
+
+	if(fwrite(lines.data(), 1, lines.size(), journal.file) != lines.size() || !syncFile(journal.file))
+		LOG(LogError) << "Error writing metadata journal \"" << journalPath << "\"";
+
+	const long size = ftell(journal.file);
+	journal.size = (size > 0) ? (size_t)size : journal.size + lines.size();
+}
+
+void replayMetaDataJournal(SystemData* system)
+{
+	const std::string journalPath = getJournalPath(system->getName());
+
+	std::ifstream stream(journalPath.c_str(), std::ios::binary);
+	if(!stream.is_open())
+		return;
+
+	TraceScopeDetail("replayMetaDataJournal", system->getName());
+
+	std::string content((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	stream.close();
+
+	// a line cut off by a crash could hold a value cut short as well, it goes before anything is appended to it
+	const size_t completeSize = content.rfind('\n') + 1;
+	if(completeSize < content.size())
+	{
+		LOG(LogWarning) << "Dropping cut off line from metadata journal \"" << journalPath << "\"";
+		if(!truncateFile(journalPath, completeSize))
+			LOG(LogError) << "Could not truncate metadata journal \"" << journalPath << "\"";
+		content.resize(completeSize);
+	}
+
+	// only the last value of a key counts, but the keys of a file are set in the order they were journaled.
+	// The files are split by directory and file name like FileData keeps them, so matching doesn't build their paths
+	typedef std::vector<std::pair<std::string, std::string>> FileChanges;
+	std::unordered_map<std::string, std::unordered_map<std::string, FileChanges>> changes;
+	size_t numEntries = 0;
+
+	for(size_t start = 0, end = content.find('\n'); end != std::string::npos; start = end + 1, end = content.find('\n', start))
+	{
+		const size_t keyStart = content.find('\t', start) + 1;
+		if(keyStart == 0 || keyStart > end)
+			continue;
+
+		const size_t valueStart = content.find('\t', keyStart) + 1;
+		if(valueStart == 0 || valueStart > end || content.find('\t', valueStart) < end)
+		{
+			LOG(LogWarning) << "Skipping broken line in metadata journal \"" << journalPath << "\"";
+			continue;
+		}
+
+		const std::string path = Utils::FileSystem::resolveRelativePath(unescape(content, start, keyStart - 1), system->getStartPath(), false, true);
+		const size_t nameStart = path.find_last_of('/') + 1;
+		changes[path.substr(0, nameStart)][path.substr(nameStart)].push_back(std::make_pair(unescape(content, keyStart, valueStart - 1), unescape(content, valueStart, end)));
+		++numEntries;
+	}
+
+	size_t numApplied = 0;
+	system->getRootFolder()->visitFiles(GAME | FOLDER, [&changes, &numApplied](FileData* file) -> bool
+	{
+		auto directory = changes.find(file->getDirectory());
+		if(directory == changes.cend())
+			return true;
+
+		auto it = directory->second.find(file->getFileName());
+		if(it == directory->second.cend())
+			return true;
+
+		for(auto change = it->second.cbegin(); change != it->second.cend(); ++change)
+			file->metadata.set(change->first, change->second);
+
+		numApplied += it->second.size();
+		return true;
+	});
+
+	{
+		std::unique_lock<std::mutex> lock(sJournalMutex);
+
+		Journal& journal = sJournals[system->getName()];
+		journal.size = content.size();
+	}
+
+	LOG(LogInfo) << "Replayed " << numApplied << " of " << numEntries << " metadata journal entries for system \"" << system->getName() << "\"";
+}
+
+size_t getMetaDataJournalSize(SystemData* system)
+{
+	std::unique_lock<std::mutex> lock(sJournalMutex);
+
+	auto it = sJournals.find(system->getName());
+	return (it != sJournals.cend()) ? it->second.size : 0;
+}
+
+void trimMetaDataJournal(const std::string& systemName, size_t size)
+{
+	std::unique_lock<std::mutex> lock(sJournalMutex);
+
+	auto it = sJournals.find(systemName);
+	if(it == sJournals.cend())
+		return;
+
+	Journal&          journal     = it->second;
+	const std::string journalPath = getJournalPath(systemName);
+
+	if(journal.file != NULL)
+	{
+		fclose(journal.file);
+		journal.file = NULL;
+	}
+
+	if(journal.size <= size)
+	{
+		Utils::FileSystem::removeFile(journalPath);
+		sJournals.erase(it);
+		return;
+	}
+
+	// keep whatever was appended while the gamelist was being written
+	std::ifstream stream(journalPath.c_str(), std::ios::binary);
+	stream.seekg(size);
+	const std::string rest((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	stream.close();
+
+	const std::string tempPath = journalPath + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	bool ok = (file != NULL) && fwrite(rest.data(), 1, rest.size(), file) == rest.size() && syncFile(file);
+	if(file != NULL)
+		ok = (fclose(file) == 0) && ok;
+
+#if defined(_WIN32)
+	if(ok)
+		remove(journalPath.c_str());
+#endif // _WIN32
+	if(!ok || rename(tempPath.c_str(), journalPath.c_str()) != 0)
+	{
+		// the whole journal stays, replaying what is in gamelist.xml already does no harm
+		LOG(LogWarning) << "Could not trim metadata journal \"" << journalPath << "\"";
+		Utils::FileSystem::removeFile(tempPath);
+		return;
+	}
+
+	journal.size = rest.size();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef ES_APP_META_DATA_JOURNAL_H
+#define ES_APP_META_DATA_JOURNAL_H
+
+#include "MetaData.h"
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class FileData;
+class SystemData;
+
+// Append-only log of metadata changes per system that aren't in gamelist.xml yet. Appending a few lines is
+// much cheaper than rewriting the whole gamelist, so frequent changes (i.e. play statistics) go here first and
+// are folded into gamelist.xml later on, when nobody is waiting for it.
+
+// Appends the current values of ids for file to the journal of its system, they are on disk when this returns.
+void appendMetaDataJournal(FileData* file, const std::vector<MetaDataId>& ids);
+
+// Applies the journal of a freshly loaded system to its tree. The values count as changed, so they are
+// part of the next gamelist save.
+void replayMetaDataJournal(SystemData* system);
+
+// Bytes in the journal of a system, all of them are covered by a gamelist save started right now.
+size_t getMetaDataJournalSize(SystemData* system);
+
+// Drops the first size bytes of the journal of a system after they were saved to gamelist.xml.
+// Can be called from any thread, appends made in the meantime are kept.
+void trimMetaDataJournal(const std::string& systemName, size_t size);
+
+#endif // ES_APP_META_DATA_JOURNAL_H
@@ -294,7 +294,7 @@ int NetplayLauncher::executeCommand(Window* window, FileData* game,
 		gameToUpdate->metadata.set("lastplayed",
 			Utils::Time::DateTime(Utils::Time::now()));
 		CollectionSystemManager::get()->refreshCollectionSystems(gameToUpdate);
-		gameToUpdate->getSystem()->onMetaDataSavePoint();
+		gameToUpdate->getSystem()->onPlayStatisticsChanged(gameToUpdate);
 	}
 
 	return exitCode;
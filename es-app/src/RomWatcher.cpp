@@ -0,0 +1,540 @@
+#include "RomWatcher.h"
+
+#include "utils/FileSystemUtil.h"
+#include "views/gamelist/IGameListView.h"
+#include "views/ViewController.h"
+#include "CollectionSystemManager.h"
+#include "FileData.h"
+#include "FileFilterIndex.h"
+#include "GameSearchIndex.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "MameNames.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <SDL_timer.h>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#endif // __linux__
+
+// time without new events before a batch of changes is applied, copies over the network arrive in bursts
+#define SETTLE_TIME 500
+
+#if defined(__linux__)
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE | IN_ONLYDIR;
+#endif // __linux__
+
+RomWatcher* RomWatcher::sInstance = nullptr;
+
+void RomWatcher::init()
+{
+	if(!sInstance)
+		sInstance = new RomWatcher();
+
+} // init
+
+void RomWatcher::deinit()
+{
+	if(sInstance)
+	{
+		delete sInstance;
+		sInstance = nullptr;
+	}
+
+} // deinit
+
+RomWatcher* RomWatcher::getInstance()
+{
+	if(!sInstance)
+		sInstance = new RomWatcher();
+
+	return sInstance;
+
+} // getInstance
+
+static std::vector<bool> getSystemVisibility()
+{
+	std::vector<bool> visible;
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		visible.push_back((*it)->isVisible());
+
+	return visible;
+
+} // getSystemVisibility
+
+// rebuilds the carousel if systems appeared or disappeared since visible was taken
+static void refreshSystemList(const std::vector<bool>& visible)
+{
+	if(getSystemVisibility() != visible)
+		ViewController::get()->reloadSystemListView();
+
+} // refreshSystemList
+
+// re-sorts the tree of a system after files were added or removed and repopulates its view
+static void refreshSystem(SystemData* system, bool filesAdded)
+{
+	FileData* root = system->getRootFolder();
+
+	root->sort(getSortTypeFromString(root->getSortDescription()));
+	system->setShuffledCacheDirty();
+	ViewController::get()->onFileChanged(root, filesAdded ? FILE_ADDED : FILE_REMOVED);
+
+} // refreshSystem
+
+RomWatcher::RomWatcher() : mFd(-1), mLastEventTime(0)
+{
+#if defined(__linux__)
+	if(!Settings::getInstance()->getBool("WatchRomFolders"))
+		return;
+
+	mFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if(mFd < 0)
+	{
+		LOG(LogWarning) << "RomWatcher: inotify is not available (" << strerror(errno) << "), rom folders are not watched";
+		return;
+	}
+
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+	{
+		SystemData* system = *it;
+		if(system->isCollection() || !system->isGameSystem())
+			continue;
+
+		// every folder that made it into the tree, the root included
+		const std::vector<std::pair<std::string, Utils::FileSystem::FileStamp>>& folders = system->getScannedFolders();
+		for(auto folderIt = folders.cbegin(); folderIt != folders.cend(); folderIt++)
+			addWatch(folderIt->first, system);
+
+		const std::string gamelistFolder = Utils::FileSystem::getParent(system->getGamelistPath(false));
+		if(Utils::FileSystem::isDirectory(gamelistFolder))
+			addWatch(gamelistFolder, system);
+	}
+
+	LOG(LogInfo) << "RomWatcher: watching " << mWatches.size() << " folders";
+#endif // __linux__
+
+} // RomWatcher
+
+RomWatcher::~RomWatcher()
+{
+#if defined(__linux__)
+	if(mFd >= 0)
+		close(mFd);
+#endif // __linux__
+
+} // ~RomWatcher
+
+void RomWatcher::update()
+{
+	if(mFd < 0)
+		return;
+
+	readEvents();
+
+	if(!mPendingChanges.empty() && (SDL_GetTicks() - mLastEventTime) >= SETTLE_TIME)
+		applyChanges();
+
+} // update
+
+void RomWatcher::reloadGamelist(SystemData* system)
+{
+	const std::vector<bool> visible = getSystemVisibility();
+
+	if(mergeGamelistChanges(system))
+		refreshSystemList(visible);
+
+} // reloadGamelist
+
+void RomWatcher::addWatch(const std::string& path, SystemData* system)
+{
+#if defined(__linux__)
+	const int wd = inotify_add_watch(mFd, path.c_str(), WATCH_MASK);
+	if(wd < 0)
+	{
+		// the default limit of watches is easily reached with huge romsets, only complain once
+		static bool warned = false;
+		if(!warned)
+		{
+			LOG(LogWarning) << "RomWatcher: can't watch \"" << path << "\" (" << strerror(errno) << "), some changes will need a restart to show up";
+			warned = true;
+		}
+		return;
+	}
+
+	// the same folder reached under another path (i.e. after a move) gives back the watch it already has
+	Watch& watch = mWatches[wd];
+	if(watch.path != path)
+	{
+		if(!watch.path.empty())
+			mWatchedPaths.erase(watch.path);
+
+		watch.path = path;
+		mWatchedPaths[path] = wd;
+	}
+
+	if(std::find(watch.systems.cbegin(), watch.systems.cend(), system) == watch.systems.cend())
+		watch.systems.push_back(system);
+#endif // __linux__
+
+} // addWatch
+
+void RomWatcher::removeWatches(const std::string& path)
+{
+#if defined(__linux__)
+	// the folder and everything below it
+	const std::string prefix = path + "/";
+	for(auto it = mWatchedPaths.begin(); it != mWatchedPaths.end(); )
+	{
+		if(it->first == path || it->first.compare(0, prefix.size(), prefix) == 0)
+		{
+			inotify_rm_watch(mFd, it->second);
+			mWatches.erase(it->second);
+			it = mWatchedPaths.erase(it);
+		}
+		else
+			it++;
+	}
+#endif // __linux__
+
+} // removeWatches
+
+void RomWatcher::readEvents()
+{
+#if defined(__linux__)
+	char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+	ssize_t length;
+
+	while((length = read(mFd, buffer, sizeof(buffer))) > 0)
+	{
+		const inotify_event* event;
+		for(char* ptr = buffer; ptr < buffer + length; ptr += sizeof(inotify_event) + event->len)
+		{
+			event = (const inotify_event*)ptr;
+
+			if(event->mask & IN_Q_OVERFLOW)
+			{
+				LOG(LogWarning) << "RomWatcher: inotify queue overflowed, some changes will need a restart to show up";
+				continue;
+			}
+
+			auto watchIt = mWatches.find(event->wd);
+			if(watchIt == mWatches.cend())
+				continue;
+
+			// the folder is gone, its removal was already reported by its parent
+			if(event->mask & IN_IGNORED)
+			{
+				auto pathIt = mWatchedPaths.find(watchIt->second.path);
+				if(pathIt != mWatchedPaths.cend() && pathIt->second == event->wd)
+					mWatchedPaths.erase(pathIt);
+				mWatches.erase(watchIt);
+				continue;
+			}
+
+			if(event->len == 0)
+				continue;
+
+			const std::string name        = event->name;
+			const std::string path        = watchIt->second.path + "/" + name;
+			const bool        isDirectory = (event->mask & IN_ISDIR) != 0;
+			const bool        written     = (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) != 0;
+			ChangeType        type;
+
+			if(name == "gamelist.xml" && !isDirectory && written)
+				type = CHANGE_GAMELIST;
+			else if(event->mask & (IN_DELETE | IN_MOVED_FROM))
+				type = CHANGE_REMOVED;
+			else if(written || (isDirectory && (event->mask & IN_CREATE)))
+				type = CHANGE_ADDED;
+			else
+				continue;
+
+			Utils::FileSystem::forgetExists(path, isDirectory);
+
+			// only the last change of a path counts, i.e. a file that is added and removed again is just removed
+			Change& change     = mPendingChanges[path];
+			change.type        = type;
+			change.isDirectory = isDirectory;
+			change.systems     = watchIt->second.systems;
+
+			mLastEventTime = SDL_GetTicks();
+		}
+	}
+#endif // __linux__
+
+} // readEvents
+
+void RomWatcher::applyChanges()
+{
+	std::map<std::string, Change> changes;
+	changes.swap(mPendingChanges);
+
+	const std::vector<bool> visible       = getSystemVisibility();
+	const bool              trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
+
+	std::vector<SystemData*>    gamelistSystems;
+	std::map<SystemData*, bool> changedSystems; // system -> files were added
+	std::vector<FileData*>      added;
+	bool                        refresh = false;
+
+	for(auto it = changes.cbegin(); it != changes.cend(); it++)
+	{
+		const std::string& path   = it->first;
+		const Change&      change = it->second;
+
+		for(auto sysIt = change.systems.cbegin(); sysIt != change.systems.cend(); sysIt++)
+		{
+			SystemData* system = *sysIt;
+
+			switch(change.type)
+			{
+				case CHANGE_GAMELIST:
+				{
+					// a gamelist.xml in a rom sub folder is no gamelist of ours
+					if(path == system->getGamelistPath(false) && std::find(gamelistSystems.cbegin(), gamelistSystems.cend(), system) == gamelistSystems.cend())
+						gamelistSystems.push_back(system);
+				}
+				break;
+
+				case CHANGE_ADDED:
+				{
+					// with ParseGamelistOnly the tree only holds what gamelist.xml says
+					if(!trustGamelist && addPath(system, path, change.isDirectory, added))
+						changedSystems[system] = true;
+				}
+				break;
+
+				case CHANGE_REMOVED:
+				{
+					if(removePath(system, path) && changedSystems.find(system) == changedSystems.cend())
+						changedSystems[system] = false;
+				}
+				break;
+			}
+		}
+	}
+
+	// gamelists first, they can hold new files as well and then these are loaded with their metadata right away
+	for(auto it = gamelistSystems.cbegin(); it != gamelistSystems.cend(); it++)
+		refresh |= mergeGamelistChanges(*it);
+
+	if(!added.empty())
+		CollectionSystemManager::get()->refreshCollectionSystems(added);
+
+	for(auto it = added.cbegin(); it != added.cend(); it++)
+		GameSearchIndex::onGameChanged(*it);
+
+	for(auto it = changedSystems.cbegin(); it != changedSystems.cend(); it++)
+	{
+		LOG(LogInfo) << "RomWatcher: updated \"" << it->first->getName() << "\"";
+		refreshSystem(it->first, it->second);
+	}
+
+	if(refresh || !changedSystems.empty())
+		refreshSystemList(visible);
+
+} // applyChanges
+
+bool RomWatcher::mergeGamelistChanges(SystemData* system)
+{
+	const std::string path = system->getGamelistPath(false);
+
+	// unchanged since it was last read, or written by ourselves; taken before merging so that a change made
+	// meanwhile is merged next time
+	const Utils::FileSystem::FileStamp stamp = Utils::FileSystem::getFileStamp(path);
+	if(!system->isGamelistChanged(stamp))
+		return false;
+
+	LOG(LogInfo) << "RomWatcher: merging \"" << path << "\"";
+
+	std::vector<FileData*> added;
+	std::vector<FileData*> changed;
+	mergeGamelist(system, added, changed);
+	system->setGamelistStamp(stamp);
+
+	if(added.empty() && changed.empty())
+		return false;
+
+	std::vector<FileData*> files(added);
+	files.insert(files.cend(), changed.cbegin(), changed.cend());
+	CollectionSystemManager::get()->refreshCollectionSystems(files);
+
+	for(auto it = files.cbegin(); it != files.cend(); it++)
+		GameSearchIndex::onGameChanged(*it);
+
+	// one view reload covers all the changed metadata
+	if(!changed.empty())
+		ViewController::get()->onFileChanged(changed.front(), FILE_METADATA_CHANGED);
+
+	refreshSystem(system, !added.empty());
+	return true;
+
+} // mergeGamelistChanges
+
+bool RomWatcher::addPath(SystemData* system, const std::string& path, bool isDirectory, std::vector<FileData*>& added)
+{
+	const std::string name = Utils::FileSystem::getFileName(path);
+	if(name.empty() || (name[0] == '.' && !Settings::getInstance()->getBool("ShowHiddenFiles")))
+		return false;
+
+	// the parent is not part of the tree (i.e. hidden) or is a game folder, the same as when scanning.
+	// A folder that was still empty is only watched, the first thing in it brings it in along with the rest
+	const std::string parentPath = Utils::FileSystem::getParent(path);
+	FileData* parent = findFile(system, parentPath);
+	if(!parent)
+		return (mWatchedPaths.find(parentPath) != mWatchedPaths.cend()) && addPath(system, parentPath, true, added);
+
+	if(parent->getType() != FOLDER)
+		return false;
+
+	// known already, i.e. a rom that was overwritten
+	if(parent->getChildrenByFilename().find(name) != parent->getChildrenByFilename().cend())
+		return false;
+
+	// the path can be gone again by the time the batch is applied
+	if(!isDirectory && !Utils::FileSystem::isRegularFile(path))
+		return false;
+
+	FileData* file;
+	if(isRomPath(system, path))
+		file = new (system->getArena()) FileData(GAME, path, system->getSystemEnvData(), system);
+	else if(isDirectory)
+		file = new (system->getArena()) FileData(FOLDER, path, system->getSystemEnvData(), system);
+	else
+		return false;
+
+	parent->addChild(file);
+
+	if(file->getType() == GAME)
+	{
+		system->getIndex()->addToIndex(file);
+		added.push_back(file);
+		return true;
+	}
+
+	// whatever was copied into the folder before it was watched has to be picked up by scanning it
+	addWatch(path, system);
+	system->populateFolder(file);
+
+	// a folder without games doesn't show up, the same as when scanning. It stays watched for when it gets some
+	if(file->getChildren().empty())
+	{
+		delete file;
+		return false;
+	}
+
+	file->visitFiles(GAME | FOLDER, [this, system, &added](FileData* child) -> bool
+	{
+		if(child->getType() == FOLDER)
+		{
+			addWatch(child->getPath(), system);
+			return true;
+		}
+
+		system->getIndex()->addToIndex(child);
+		added.push_back(child);
+		return true;
+	});
+
+	return true;
+
+} // addPath
+
+bool RomWatcher::removePath(SystemData* system, const std::string& path)
+{
+	removeWatches(path);
+
+	FileData* file = findFile(system, path);
+	if(!file || file == system->getRootFolder())
+		return false;
+
+	removeFile(file);
+	return true;
+
+} // removePath
+
+void RomWatcher::removeFile(FileData* file)
+{
+	SystemData* system = file->getSystem();
+	std::shared_ptr<IGameListView> view;
+	if(ViewController::get()->hasGameListView(system))
+		view = ViewController::get()->getGameListView(system);
+
+	if(file->getType() == FOLDER)
+	{
+		// step out of the folder first, so the view holds no pointers into it
+		if(view)
+		{
+			for(FileData* cursor = view->getCursor(); cursor; cursor = cursor->getParent())
+			{
+				if(cursor == file)
+				{
+					view->setCursor(file);
+					break;
+				}
+			}
+		}
+
+		// copied, the children take themselves out of the folder when deleted
+		const std::vector<FileData*> children = file->getChildren();
+		for(auto it = children.cbegin(); it != children.cend(); it++)
+			removeFile(*it);
+	}
+	else
+		CollectionSystemManager::get()->deleteCollectionFiles(file);
+
+	if(view)
+		view->remove(file, false, false);
+	else
+		delete file;
+
+} // removeFile
+
+bool RomWatcher::isRomPath(SystemData* system, const std::string& path) const
+{
+	const std::vector<std::string>& extensions = system->getExtensions();
+	if(std::find(extensions.cbegin(), extensions.cend(), Utils::FileSystem::getExtension(path)) == extensions.cend())
+		return false;
+
+	// no arcade assets, the same as when scanning
+	if(system->hasPlatformId(PlatformIds::ARCADE) || system->hasPlatformId(PlatformIds::NEOGEO))
+	{
+		const std::string stem = Utils::FileSystem::getStem(path);
+		if(MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem))
+			return false;
+	}
+
+	return true;
+
+} // isRomPath
+
+FileData* RomWatcher::findFile(SystemData* system, const std::string& path) const
+{
+	FileData*          node     = system->getRootFolder();
+	const std::string& rootPath = node->getPath();
+
+	if(path == rootPath)
+		return node;
+
+	if(path.compare(0, rootPath.size() + 1, rootPath + "/") != 0)
+		return NULL;
+
+	const Utils::FileSystem::stringList pathList = Utils::FileSystem::getPathList(path.substr(rootPath.size() + 1));
+	for(auto it = pathList.cbegin(); it != pathList.cend(); it++)
+	{
+		const std::unordered_map<std::string, FileData*>& children = node->getChildrenByFilename();
+		auto child = children.find(*it);
+		if(child == children.cend())
+			return NULL;
+
+		node = child->second;
+	}
+
+	return node;
+
+} // findFile
@@ -0,0 +1,76 @@
+#pragma once
+#ifndef ES_APP_ROM_WATCHER_H
+#define ES_APP_ROM_WATCHER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class FileData;
+class SystemData;
+
+// Watches the rom folders and gamelists of the loaded systems and applies changes to the FileData trees,
+// filter indexes, collections and views in place, so new roms and savestates show up without a restart.
+// Events are only collected by inotify on Linux, reloadGamelist() works everywhere.
+class RomWatcher
+{
+public:
+
+	static void        init       ();
+	static void        deinit     ();
+	static RomWatcher* getInstance();
+
+	// Applies the changes that have settled, called from the main loop.
+	void update();
+
+	// Merges the gamelist.xml of a system into its loaded tree.
+	void reloadGamelist(SystemData* system);
+
+private:
+
+	struct Watch
+	{
+		std::string              path;
+		std::vector<SystemData*> systems;
+	};
+
+	enum ChangeType
+	{
+		CHANGE_ADDED,
+		CHANGE_REMOVED,
+		CHANGE_GAMELIST
+	};
+
+	struct Change
+	{
+		ChangeType               type;
+		bool                     isDirectory;
+		std::vector<SystemData*> systems;
+	};
+
+	 RomWatcher();
+	~RomWatcher();
+
+	void addWatch(const std::string& path, SystemData* system);
+	void removeWatches(const std::string& path);
+	void readEvents();
+	void applyChanges();
+	bool mergeGamelistChanges(SystemData* system);
+
+	bool addPath(SystemData* system, const std::string& path, bool isDirectory, std::vector<FileData*>& added);
+	bool removePath(SystemData* system, const std::string& path);
+	void removeFile(FileData* file);
+	bool isRomPath(SystemData* system, const std::string& path) const;
+	FileData* findFile(SystemData* system, const std::string& path) const;
+
+	static RomWatcher* sInstance;
+
+	int                             mFd;
+	std::map<int, Watch>            mWatches;
+	std::map<std::string, int>      mWatchedPaths;
+	std::map<std::string, Change>   mPendingChanges;
+	unsigned int                    mLastEventTime;
+
+}; // RomWatcher
+
+#endif // ES_APP_ROM_WATCHER_H
@@ -1,5 +1,6 @@
 #include "ScraperCmdLine.h"
 
+#include "Gamelist.h"
 #include "Log.h"
 #include "platform.h"
 #include "SystemData.h"
@@ -20,6 +21,7 @@ void handle_interrupt_signal(int /*p*/)
 	LOG(LogInfo) << "Interrupt received during scrape...";
 
 	SystemData::deleteSystems();
+	flushGamelistWrites();
 
 	exit(1);
 }
@@ -5,15 +5,22 @@
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
 #include "Gamelist.h"
+#include "GamelistCache.h"
+#include "MetaDataJournal.h"
 #include "Log.h"
+#include "MameNames.h"
 #include "platform.h"
 #include "Settings.h"
 #include "ThemeData.h"
 #include "views/UIModeController.h"
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <random>
+#include <unordered_set>
 #include "utils/StringUtil.h"
 #include "utils/ThreadPool.h"
+#include "utils/TraceUtil.h"
 #include "Window.h"
 
 using namespace Utils;
@@ -24,21 +31,37 @@ std::ranlux48 SystemData::sURNG = std::ranlux48(std::random_device()());
 
 
 SystemData::SystemData(const std::string& name, const std::string& fullName, SystemEnvironmentData* envData, const std::string& themeFolder, bool CollectionSystem) :
-	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true)
+	mName(name), mFullName(fullName), mEnvData(envData), mThemeFolder(themeFolder), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true), mDisplayedCountChange((unsigned int)-1), mGamelistCacheOutdated(false)
 {
+	TraceScopeDetail("SystemData", name);
+
 	mFilterIndex = new FileFilterIndex();
 
 	// if it's an actual system, initialize it, if not, just create the data structure
 	if(!CollectionSystem)
 	{
-		mRootFolder = new FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
-		mRootFolder->metadata.set("name", mFullName);
+		mRootFolder = new (mArena) FileData(FOLDER, mEnvData->mStartPath, mEnvData, this);
+		mRootFolder->metadata.set(META_NAME, mFullName);
+
+		mGamelistStamp = Utils::FileSystem::getFileStamp(getGamelistPath(false));
+
+		// the snapshot saves scanning the rom folders and parsing gamelist.xml as long as neither changed
+		const bool useCache = Settings::getInstance()->getBool("GamelistCache");
+		if(!useCache || !loadGamelistCache(this))
+		{
+			if(!Settings::getInstance()->getBool("ParseGamelistOnly"))
+				populateFolder(mRootFolder);
 
-		if(!Settings::getInstance()->getBool("ParseGamelistOnly"))
-			populateFolder(mRootFolder);
+			if(!Settings::getInstance()->getBool("IgnoreGamelist"))
+				parseGamelist(this);
 
+			if(useCache)
+				saveGamelistCache(this);
+		}
+
+		// changes that didn't make it into gamelist.xml before ES was last closed (or crashed)
 		if(!Settings::getInstance()->getBool("IgnoreGamelist"))
-			parseGamelist(this);
+			replayMetaDataJournal(this);
 
 		mRootFolder->sort(FileSorts::SortTypes.at(0));
 
@@ -47,7 +70,7 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 	else
 	{
 		// virtual systems are updated afterwards, we're just creating the data structure
-		mRootFolder = new FileData(FOLDER, "" + name, mEnvData, this);
+		mRootFolder = new (mArena) FileData(FOLDER, "" + name, mEnvData, this);
 	}
 	setIsGameSystemStatus();
 	loadTheme();
@@ -55,11 +78,11 @@ SystemData::SystemData(const std::string& name, const std::string& fullName, Sys
 
 SystemData::~SystemData()
 {
-	if(Settings::getInstance()->getString("SaveGamelistsMode") == "on exit")
-		writeMetaData();
-
-	delete mRootFolder;
+	// the whole tree goes at once, nothing has to be unlinked from its parent or taken out of the filter index
 	delete mFilterIndex;
+	mFilterIndex = NULL;
+
+	mRootFolder->deleteTree();
 }
 
 void SystemData::setIsGameSystemStatus()
@@ -70,72 +93,195 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mName != "retropie");
 }
 
-void SystemData::populateFolder(FileData* folder)
+// A folder whose entries are being turned into FileData by populateFolder().
+struct FolderScan
 {
-	const std::string& folderPath = folder->getPath();
-	if(!Utils::FileSystem::isDirectory(folderPath))
+	FolderScan(FileData* _folder) : folder(_folder), listed(false) {}
+
+	FileData*                    folder;
+	Utils::FileSystem::FileStamp stamp;
+	bool                         listed;
+	Utils::FileSystem::entryList entries;
+	std::vector<FileData*>       files;      // one per entry, NULL if the entry was skipped
+	std::vector<FolderScan*>     subFolders; // one per entry, only set if the entry became a folder
+};
+
+// levels with fewer entries than this are not worth spreading over the thread pool
+static const size_t PARALLEL_SCAN_MIN_ENTRIES = 256;
+static const size_t SCAN_CHUNK_SIZE           = 128;
+
+static void runScanTasks(size_t count, bool parallel, const std::function<void(size_t)>& task)
+{
+	if(!parallel || count < 2)
 	{
-		LOG(LogWarning) << "Error - folder with path \"" << folderPath << "\" is not a directory!";
+		for(size_t i = 0; i < count; i++)
+			task(i);
 		return;
 	}
 
-	//make sure that this isn't a symlink to a thing we already have
-	if(Utils::FileSystem::isSymlink(folderPath))
+	// waiting on the results instead of the whole pool makes this safe to use from a loader work item
+	ThreadPool* pool = ThreadPool::getShared();
+	std::vector<std::future<void>> results;
+	results.reserve(count);
+
+	for(size_t i = 0; i < count; i++)
+		results.push_back(pool->submit([&task, i] { task(i); }));
+
+	for(auto it = results.begin(); it != results.end(); ++it)
 	{
-		//if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
-		if(folderPath.find(Utils::FileSystem::getCanonicalPath(folderPath)) == 0)
+		pool->wait(*it);
+		it->get();
+	}
+}
+
+// adds the scanned entries in directory order, dropping folders which ended up without games
+static void attachFolderScan(FolderScan* scan)
+{
+	for(size_t i = 0; i < scan->files.size(); i++)
+	{
+		FileData* file = scan->files[i];
+		if(file == NULL)
+			continue;
+
+		FolderScan* subFolder = scan->subFolders[i];
+		if(subFolder != NULL)
 		{
-			LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << folderPath << "\"";
-			return;
+			attachFolderScan(subFolder);
+			delete subFolder;
+
+			if(file->getChildrenByFilename().size() == 0)
+			{
+				delete file;
+				continue;
+			}
 		}
+
+		scan->folder->addChild(file);
 	}
+}
 
-	std::string filePath;
-	std::string extension;
-	bool isGame;
-	bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
-	Utils::FileSystem::stringList dirContent = Utils::FileSystem::getDirContent(folderPath);
-	for(Utils::FileSystem::stringList::const_iterator it = dirContent.cbegin(); it != dirContent.cend(); ++it)
+void SystemData::populateFolder(FileData* folder)
+{
+	TraceScopeDetail("populateFolder", folder->getPath());
+
+	if(!Utils::FileSystem::isDirectory(folder->getPath()))
+	{
+		LOG(LogWarning) << "Error - folder with path \"" << folder->getPath() << "\" is not a directory!";
+		return;
+	}
+
+	// the tree is scanned one level at a time, the folders of a level are listed and their entries are
+	// turned into FileData in parallel
+	const bool parallel = (std::thread::hardware_concurrency() > 2);
+	const bool showHidden = Settings::getInstance()->getBool("ShowHiddenFiles");
+	const bool arcade = hasPlatformId(PlatformIds::ARCADE) || hasPlatformId(PlatformIds::NEOGEO);
+	const std::unordered_set<std::string> extensions(mEnvData->mSearchExtensions.cbegin(), mEnvData->mSearchExtensions.cend());
+
+	auto listFolder = [showHidden](FolderScan* scan)
 	{
-		filePath = *it;
+		const std::string& folderPath = scan->folder->getPath();
+		TraceScopeDetail("listFolder", folderPath);
+
+		//make sure that this isn't a symlink to a thing we already have
+		if(Utils::FileSystem::isSymlink(folderPath))
+		{
+			//if this symlink resolves to somewhere that's at the beginning of our path, it's gonna recurse
+			if(folderPath.find(Utils::FileSystem::getCanonicalPath(folderPath)) == 0)
+			{
+				LOG(LogWarning) << "Skipping infinitely recursive symlink \"" << folderPath << "\"";
+				return;
+			}
+		}
+
+		// taken before reading the folder, so anything added while reading it invalidates the gamelist cache
+		scan->stamp = Utils::FileSystem::getFileStamp(folderPath);
+		scan->listed = true;
+		scan->entries = Utils::FileSystem::getDirEntries(folderPath);
 
 		// skip hidden files and folders
-		if(!showHidden && Utils::FileSystem::isHidden(filePath))
-			continue;
+		if(!showHidden)
+		{
+			scan->entries.erase(std::remove_if(scan->entries.begin(), scan->entries.end(),
+				[](const Utils::FileSystem::DirEntry& entry) { return entry.isHidden; }), scan->entries.end());
+		}
 
-		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
-		//we first get the extension of the file itself:
-		extension = Utils::FileSystem::getExtension(filePath);
+		scan->files.resize(scan->entries.size(), NULL);
+		scan->subFolders.resize(scan->entries.size(), NULL);
+	};
 
-		//fyi, folders *can* also match the extension and be added as games - this is mostly just to support higan
-		//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
+	auto createFiles = [this, arcade, &extensions](FolderScan* scan, size_t first)
+	{
+		TraceScopeDetail("createFiles", scan->folder->getPath());
 
-		isGame = false;
-		if(std::find(mEnvData->mSearchExtensions.cbegin(), mEnvData->mSearchExtensions.cend(), extension) != mEnvData->mSearchExtensions.cend())
+		const size_t last = std::min(first + SCAN_CHUNK_SIZE, scan->entries.size());
+		for(size_t i = first; i < last; i++)
 		{
-			FileData* newGame = new FileData(GAME, filePath, mEnvData, this);
+			const Utils::FileSystem::DirEntry& entry = scan->entries[i];
 
-			// preventing new arcade assets to be added
-			if(!newGame->isArcadeAsset())
+			//fyi, folders *can* also match the extension and be added as games - this is mostly just to support higan
+			//see issue #75: https://github.com/Aloshi/EmulationStation/issues/75
+			if(extensions.find(Utils::FileSystem::getExtension(entry.path)) != extensions.cend())
 			{
-				folder->addChild(newGame);
-				isGame = true;
+				// preventing new arcade assets to be added
+				const std::string stem = Utils::FileSystem::getStem(entry.path);
+				if(!arcade || !(MameNames::getInstance()->isBios(stem) || MameNames::getInstance()->isDevice(stem)))
+				{
+					scan->files[i] = new (mArena) FileData(GAME, entry.path, mEnvData, this);
+					continue;
+				}
 			}
+
+			//add directories that also do not match an extension as folders
+			if(entry.isDirectory)
+				scan->files[i] = new (mArena) FileData(FOLDER, entry.path, mEnvData, this);
+		}
+	};
+
+	FolderScan* rootScan = new FolderScan(folder);
+	std::vector<FolderScan*> level(1, rootScan);
+
+	while(!level.empty())
+	{
+		runScanTasks(level.size(), parallel, [&level, &listFolder](size_t i) { listFolder(level[i]); });
+
+		// split the entries of the whole level into chunks, so a single huge folder is spread as well
+		std::vector<std::pair<FolderScan*, size_t>> chunks;
+		size_t numEntries = 0;
+		for(auto it = level.cbegin(); it != level.cend(); ++it)
+		{
+			for(size_t first = 0; first < (*it)->entries.size(); first += SCAN_CHUNK_SIZE)
+				chunks.push_back(std::make_pair(*it, first));
+			numEntries += (*it)->entries.size();
 		}
 
-		//add directories that also do not match an extension as folders
-		if(!isGame && Utils::FileSystem::isDirectory(filePath))
+		runScanTasks(chunks.size(), parallel && (numEntries >= PARALLEL_SCAN_MIN_ENTRIES),
+			[&chunks, &createFiles](size_t i) { createFiles(chunks[i].first, chunks[i].second); });
+
+		std::vector<FolderScan*> nextLevel;
+		for(auto it = level.cbegin(); it != level.cend(); ++it)
 		{
-			FileData* newFolder = new FileData(FOLDER, filePath, mEnvData, this);
-			populateFolder(newFolder);
-
-			//ignore folders that do not contain games
-			if(newFolder->getChildrenByFilename().size() == 0)
-				delete newFolder;
-			else
-				folder->addChild(newFolder);
+			FolderScan* scan = *it;
+			if(scan->listed)
+				mScannedFolders.push_back(std::make_pair(scan->folder->getPath(), scan->stamp));
+
+			for(size_t i = 0; i < scan->files.size(); i++)
+			{
+				if(scan->files[i] != NULL && scan->files[i]->getType() == FOLDER)
+				{
+					scan->subFolders[i] = new FolderScan(scan->files[i]);
+					nextLevel.push_back(scan->subFolders[i]);
+				}
+			}
+
+			scan->entries.clear();
+			scan->entries.shrink_to_fit();
 		}
+
+		level.swap(nextLevel);
 	}
+
+	attachFolderScan(rootScan);
+	delete rootScan;
 }
 
 void SystemData::indexAllGameFilters(const FileData* folder)
@@ -264,6 +410,9 @@ bool SystemData::loadConfig(Window* window)
 {
 	deleteSystems();
 
+	// gamelists saved by the old systems are read again right away
+	flushGamelistWrites();
+
 	std::string path = getConfigPath(false);
 
 	LOG(LogInfo) << "Loading system config file " << path << "...";
@@ -312,7 +461,7 @@ bool SystemData::loadConfig(Window* window)
 
 	if (std::thread::hardware_concurrency() > 2 && Settings::getInstance()->getBool("ThreadedLoading"))
 	{
-		pThreadPool = new ThreadPool();
+		pThreadPool = ThreadPool::getShared();
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
@@ -372,7 +521,6 @@ bool SystemData::loadConfig(Window* window)
 		}
 
 		delete[] systems;
-		delete pThreadPool;
 
 		if (window != NULL)
 			window->renderLoadingScreen("Favorites", systemCount == 0 ? 0 : currentSystem / systemCount);
@@ -438,6 +586,52 @@ void SystemData::writeExampleConfig(const std::string& path)
 
 void SystemData::deleteSystems()
 {
+	// the gamelists are built on all cores and written in parallel, cabinets tend to be switched off right after quitting
+	const auto startTs = std::chrono::system_clock::now();
+	const uint64_t startBytes = getGamelistBytesWritten();
+	const bool saveAll = Settings::getInstance()->getString("SaveGamelistsMode") == "on exit";
+
+	// display names of arcade games are looked up while saving, the instance must not be created by the workers
+	MameNames::getInstance();
+
+	Utils::ThreadPool* pool = Utils::ThreadPool::getShared();
+	std::vector<std::future<void>> saves;
+	for(auto it = sSystemVector.cbegin(); it != sSystemVector.cend(); it++)
+	{
+		SystemData* system = *it;
+		if(saveAll)
+			saves.push_back(pool->submit([system] { system->writeMetaData(); }));
+		else if(getMetaDataJournalSize(system) > 0)
+			saves.push_back(pool->submit([system] { system->compactMetaDataJournal(); }));
+	}
+
+	if(!saves.empty())
+	{
+		for(auto it = saves.begin(); it != saves.end(); it++)
+			pool->wait(*it);
+		flushGamelistWrites();
+
+		const auto endTs = std::chrono::system_clock::now();
+		LOG(LogInfo) << "Saved gamelists of " << saves.size() << " systems (" << (getGamelistBytesWritten() - startBytes) << " bytes) in " << std::chrono::duration_cast<std::chrono::milliseconds>(endTs - startTs).count() << " ms";
+	}
+
+	// the snapshots of the trees whose gamelists were written while running or just now, with the stamps they got
+	std::vector<std::future<void>> snapshots;
+	for(auto it = sSystemVector.cbegin(); it != sSystemVector.cend(); it++)
+	{
+		SystemData* system = *it;
+		if(!system->mGamelistCacheOutdated)
+			continue;
+
+		if(snapshots.empty())
+			flushGamelistWrites();
+
+		snapshots.push_back(pool->submit([system] { system->refreshGamelistCache(); }));
+	}
+
+	for(auto it = snapshots.begin(); it != snapshots.end(); it++)
+		pool->wait(*it);
+
 	for(unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
 		delete sSystemVector.at(i);
@@ -537,7 +731,7 @@ bool SystemData::hasGamelist() const
 
 unsigned int SystemData::getGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME).size();
+	return mRootFolder->getGameCount();
 }
 
 SystemData* SystemData::getRandomSystem()
@@ -577,11 +771,23 @@ FileData* SystemData::getRandomGame()
 
 unsigned int SystemData::getDisplayedGameCount() const
 {
-	return (unsigned int)mRootFolder->getFilesRecursive(GAME, true).size();
+	if(!mFilterIndex->isFiltered())
+		return mRootFolder->getGameCount();
+
+	// adding and removing games keeps the counts right, only a change of the filters or the indexed metadata needs a recount
+	if(mDisplayedCountChange != mFilterIndex->getChangeCount())
+	{
+		mRootFolder->countDisplayedGames();
+		mDisplayedCountChange = mFilterIndex->getChangeCount();
+	}
+
+	return mRootFolder->getDisplayedGameCount();
 }
 
 void SystemData::loadTheme()
 {
+	TraceScopeDetail("loadTheme", mName);
+
 	mTheme = std::make_shared<ThemeData>();
 
 	std::string path = getThemePath();
@@ -609,8 +815,52 @@ void SystemData::writeMetaData() {
 	if(Settings::getInstance()->getBool("IgnoreGamelist") || mIsCollectionSystem)
 		return;
 
+	// the cache can only be refreshed from memory if gamelist.xml wasn't changed by someone else since it was read
+	const bool refreshCache = Settings::getInstance()->getBool("GamelistCache") &&
+		!isGamelistChanged(Utils::FileSystem::getFileStamp(getGamelistPath(false)));
+
+	// the journal is covered by this save, what is appended to it from now on isn't
+	const size_t journalSize = getMetaDataJournalSize(this);
+	const std::string name = getName();
+	GamelistWrittenCallback onWritten = nullptr;
+	if(journalSize > 0)
+	{
+		onWritten = [name, journalSize](bool written)
+		{
+			if(written)
+				trimMetaDataJournal(name, journalSize);
+		};
+	}
+
 	//save changed game data back to xml
-	updateGamelist(this);
+	updateGamelist(this, onWritten);
+
+	// the stamp the snapshot needs is only known once the write is done
+	if(refreshCache)
+		mGamelistCacheOutdated = true;
+}
+
+bool SystemData::isGamelistChanged(const Utils::FileSystem::FileStamp& stamp)
+{
+	if(stamp == mGamelistStamp)
+		return false;
+
+	if(stamp == getWrittenGamelistStamp(getGamelistPath(true)))
+	{
+		mGamelistStamp = stamp;
+		return false;
+	}
+
+	return true;
+}
+
+void SystemData::refreshGamelistCache()
+{
+	mGamelistCacheOutdated = false;
+
+	// only if what's on disk is still what we wrote
+	if(!isGamelistChanged(Utils::FileSystem::getFileStamp(getGamelistPath(false))))
+		saveGamelistCache(this);
 }
 
 void SystemData::onMetaDataSavePoint() {
@@ -619,3 +869,23 @@ void SystemData::onMetaDataSavePoint() {
 
 	writeMetaData();
 }
+
+void SystemData::onPlayStatisticsChanged(FileData* game)
+{
+	if(Settings::getInstance()->getString("SaveGamelistsMode") == "never" || Settings::getInstance()->getBool("IgnoreGamelist"))
+		return;
+
+	if(!Settings::getInstance()->getBool("MetaDataJournal"))
+	{
+		onMetaDataSavePoint();
+		return;
+	}
+
+	appendMetaDataJournal(game, { META_PLAYCOUNT, META_LASTPLAYED });
+}
+
+void SystemData::compactMetaDataJournal()
+{
+	if(getMetaDataJournalSize(this) > 0)
+		writeMetaData();
+}
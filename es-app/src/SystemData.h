@@ -2,11 +2,14 @@
 #ifndef ES_APP_SYSTEM_DATA_H
 #define ES_APP_SYSTEM_DATA_H
 
+#include "utils/Arena.h"
+#include "utils/FileSystemUtil.h"
 #include "PlatformId.h"
 #include <algorithm>
 #include <memory>
 #include <random>
 #include <string>
+#include <time.h>
 #include <vector>
 
 #include <pugixml.hpp>
@@ -74,10 +77,29 @@ public:
 	// Load or re-load theme.
 	void loadTheme();
 
+	// Scans a folder of this system on disk and adds the games and folders found below it.
+	void populateFolder(FileData* folder);
+
 	FileFilterIndex* getIndex() { return mFilterIndex; };
+	// every FileData of this system's tree is allocated here and released at once with the system
+	inline Utils::Arena& getArena() { return mArena; }
 	void onMetaDataSavePoint();
+	// playcount and lastplayed of game changed, goes to the metadata journal instead of rewriting gamelist.xml
+	void onPlayStatisticsChanged(FileData* game);
+	// folds the metadata journal into gamelist.xml, if there is one
+	void compactMetaDataJournal();
 	void setShuffledCacheDirty();
 
+	// folders read while populating the tree and their stamp at that point, used to validate the gamelist cache
+	inline const std::vector<std::pair<std::string, Utils::FileSystem::FileStamp>>& getScannedFolders() const { return mScannedFolders; }
+	inline void setScannedFolders(const std::vector<std::pair<std::string, Utils::FileSystem::FileStamp>>& folders) { mScannedFolders = folders; }
+	// stamp of gamelist.xml when it was last read by us
+	inline const Utils::FileSystem::FileStamp& getGamelistStamp() const { return mGamelistStamp; }
+	inline void setGamelistStamp(const Utils::FileSystem::FileStamp& gamelistStamp) { mGamelistStamp = gamelistStamp; }
+	// whether the gamelist.xml with stamp was changed by someone else since it was read, a version we wrote ourselves
+	// becomes the one that was read
+	bool isGamelistChanged(const Utils::FileSystem::FileStamp& stamp);
+
 private:
 	static SystemData* loadSystem(pugi::xml_node system);
 
@@ -89,14 +111,21 @@ private:
 	std::string mThemeFolder;
 	std::shared_ptr<ThemeData> mTheme;
 
-	void populateFolder(FileData* folder);
 	void indexAllGameFilters(const FileData* folder);
 	void setIsGameSystemStatus();
 	void writeMetaData();
+	void refreshGamelistCache();
 
 	FileFilterIndex* mFilterIndex;
 
+	Utils::Arena mArena;
 	FileData* mRootFolder;
+	// filter index change count the displayed game counts of the tree were last counted for
+	mutable unsigned int mDisplayedCountChange;
+	std::vector<std::pair<std::string, Utils::FileSystem::FileStamp>> mScannedFolders;
+	Utils::FileSystem::FileStamp mGamelistStamp;
+	// the gamelist cache is refreshed once what writeMetaData() wrote is on disk
+	bool mGamelistCacheOutdated;
 	// for getRandomGame()
 	std::vector<FileData*> mGamesShuffled;
 };
@@ -224,6 +224,10 @@ void SystemScreenSaver::handleScreenSaverEditingCollection()
 
 void SystemScreenSaver::startScreenSaver(SystemData* system)
 {
+	// nobody is waiting for anything now, a good time to fold the play statistics into the gamelists
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		(*it)->compactMetaDataJournal();
+
 	mSystem = system;
 	// if set to index files in background, start thread
 	if (Settings::getInstance()->getBool("BackgroundIndexing"))
@@ -474,10 +478,7 @@ void SystemScreenSaver::backgroundIndexing()
 }
 
 void SystemScreenSaver::getAllGamelistNodesForSystem(SystemData* system) {
-	std::vector<FileData*> subsysFiles {};
-	FileData* rootFileData = system->getRootFolder();
-	subsysFiles = rootFileData->getFilesRecursive(FileType::GAME, true);
-	mAllFiles.insert(mAllFiles.end(), subsysFiles.begin(), subsysFiles.end());
+	system->getRootFolder()->visitFiles(FileType::GAME, [this](FileData* file) -> bool { mAllFiles.push_back(file); return true; }, true);
 }
 
 void SystemScreenSaver::getAllGamelistNodes()
@@ -0,0 +1,603 @@
+//EmulationStation data layer benchmark
+//Generates synthetic rom folders and gamelists and times loading, sorting, filtering and collections on them.
+//The Window is never initialised, so no display or GPU is needed.
+
+#include "CollectionSystemManager.h"
+#include "EmulationStation.h"
+#include "FileData.h"
+#include "FileFilterIndex.h"
+#include "FileSorts.h"
+#include "GameSearchIndex.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "MameNames.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include "Window.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "views/ViewController.h"
+#include <SDL_main.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif // __GLIBC__
+
+// games per generated subfolder, roughly every tenth game lives in one
+#define GAMES_PER_FOLDER 50
+
+struct BenchOptions
+{
+	std::vector<int> games;
+	int              systems;
+	int              repeat;
+	std::string      dir;
+	std::string      output;
+};
+
+struct Timing
+{
+	std::string         name;
+	std::vector<double> samples; // milliseconds
+};
+
+struct ScaleResult
+{
+	int                           games;
+	int                           files;
+	size_t                        treeBytes; // heap the loaded systems take, 0 where it can't be measured
+	std::vector<Timing>           timings;
+	Utils::FileSystem::CacheStats pathCache; // lookups while benchmarking this scale, entries at its end
+};
+
+static const char* platforms[] = { "nes", "snes", "megadrive", "arcade", "psx", "n64", "gba", "gb", "mastersystem", "pcengine" };
+static const char* genres[] = { "Action", "Adventure", "Fighting", "Platform", "Puzzle", "Racing", "Role Playing", "Shooter", "Sports", "Strategy" };
+static const char* companies[] = { "Acclaim", "Capcom", "Data East", "Hudson Soft", "Irem", "Konami", "Namco", "Sega", "SNK", "Taito", "Technos", "Tecmo" };
+static const char* words[] = { "Super", "Mega", "Dragon", "Ninja", "Street", "Space", "Final", "Legend", "Turbo", "Shadow", "Golden", "Night", "Fury", "Quest", "Warrior", "Racer" };
+
+#define COUNT_OF(_array) (sizeof(_array) / sizeof(_array[0]))
+
+// bytes of heap in use, only known with glibc
+static size_t getHeapUsage()
+{
+#if defined(__GLIBC__) && ((__GLIBC__ > 2) || (__GLIBC_MINOR__ >= 33))
+	return mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+	return (unsigned int)mallinfo().uordblks;
+#else
+	return 0;
+#endif
+}
+
+static double elapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool parseArgs(int argc, char* argv[], BenchOptions& options)
+{
+	Utils::FileSystem::setExePath(argv[0]);
+
+	for(int i = 1; i < argc; i++)
+	{
+		const bool hasValue = (i < argc - 1);
+
+		if(strcmp(argv[i], "--games") == 0 && hasValue)
+		{
+			options.games.clear();
+			std::vector<std::string> list = Utils::String::delimitedStringToVector(argv[i + 1], ",");
+			for(auto it = list.cbegin(); it != list.cend(); it++)
+			{
+				const int count = atoi(it->c_str());
+				if(count <= 0)
+				{
+					std::cerr << "Invalid game count \"" << *it << "\".\n";
+					return false;
+				}
+				options.games.push_back(count);
+			}
+			i++; // skip the argument value
+		}else if(strcmp(argv[i], "--systems") == 0 && hasValue)
+		{
+			options.systems = std::max(1, atoi(argv[i + 1]));
+			i++; // skip the argument value
+		}else if(strcmp(argv[i], "--repeat") == 0 && hasValue)
+		{
+			options.repeat = std::max(1, atoi(argv[i + 1]));
+			i++; // skip the argument value
+		}else if(strcmp(argv[i], "--dir") == 0 && hasValue)
+		{
+			options.dir = Utils::FileSystem::getAbsolutePath(argv[i + 1]);
+			i++; // skip the argument value
+		}else if(strcmp(argv[i], "--output") == 0 && hasValue)
+		{
+			options.output = Utils::FileSystem::getAbsolutePath(argv[i + 1]);
+			i++; // skip the argument value
+		}else if(strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
+		{
+			std::cout <<
+				"es-bench " PROGRAM_VERSION_STRING "\n"
+				"Times the EmulationStation data layer on generated rom folders and gamelists.\n\n"
+				"Command line arguments:\n"
+				"--games N[,N...]               game counts to benchmark (default 1000,10000,50000,200000)\n"
+				"--systems N                    number of systems the games are spread over (default 10)\n"
+				"--repeat N                     runs per measurement (default 5)\n"
+				"--dir PATH                     where the synthetic data is generated, it is reused\n"
+				"                               by later runs (default ./es-bench-data)\n"
+				"--output FILE                  write the results as JSON to FILE\n"
+				"                               (default ./es-bench.json)\n"
+				"--help, -h                     show this help\n";
+			return false;
+		}else{
+			std::cerr << "Invalid argument \"" << argv[i] << "\", see --help.\n";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static std::string makeGameName(std::mt19937& random, int index)
+{
+	std::uniform_int_distribution<int> word(0, COUNT_OF(words) - 1);
+	std::stringstream ss;
+	ss << words[word(random)] << " " << words[word(random)] << " " << std::setw(6) << std::setfill('0') << index;
+	return ss.str();
+}
+
+static std::string makeDate(std::mt19937& random, int firstYear, int lastYear)
+{
+	std::uniform_int_distribution<int> year(firstYear, lastYear);
+	std::uniform_int_distribution<int> month(1, 12);
+	std::uniform_int_distribution<int> day(1, 28);
+	std::stringstream ss;
+	ss << year(random) << std::setw(2) << std::setfill('0') << month(random) << std::setw(2) << day(random) << "T000000";
+	return ss.str();
+}
+
+// Writes es_systems.cfg, the rom files and a gamelist.xml per system below dir, always the same for the same arguments.
+static bool generateData(const std::string& dir, int systemCount, int gameCount)
+{
+	std::mt19937 random(gameCount);
+	std::uniform_int_distribution<int> percent(0, 99);
+	std::uniform_int_distribution<int> genre(0, COUNT_OF(genres) - 1);
+	std::uniform_int_distribution<int> company(0, COUNT_OF(companies) - 1);
+	std::uniform_int_distribution<int> players(1, 4);
+	std::uniform_int_distribution<int> rating(0, 10);
+	std::uniform_int_distribution<int> playcount(1, 50);
+
+	const std::string configDir = dir + "/.emulationstation";
+	Utils::FileSystem::createDirectory(configDir);
+
+	std::ofstream config((configDir + "/es_systems.cfg").c_str(), std::ios::out | std::ios::trunc);
+	config << "<systemList>\n";
+
+	int gameIndex = 0;
+	for(int s = 0; s < systemCount; s++)
+	{
+		std::stringstream name;
+		name << "bench" << std::setw(2) << std::setfill('0') << (s + 1);
+
+		const std::string romPath = dir + "/roms/" + name.str();
+		Utils::FileSystem::createDirectory(romPath);
+
+		config << "\t<system>\n"
+		       << "\t\t<name>" << name.str() << "</name>\n"
+		       << "\t\t<fullname>Benchmark " << (s + 1) << "</fullname>\n"
+		       << "\t\t<path>" << romPath << "</path>\n"
+		       << "\t\t<extension>.zip .ZIP .7z</extension>\n"
+		       << "\t\t<command>true %ROM%</command>\n"
+		       << "\t\t<platform>" << platforms[s % COUNT_OF(platforms)] << "</platform>\n"
+		       << "\t\t<theme>" << name.str() << "</theme>\n"
+		       << "\t</system>\n";
+
+		std::ofstream gamelist((romPath + "/gamelist.xml").c_str(), std::ios::out | std::ios::trunc);
+		gamelist << "<?xml version=\"1.0\"?>\n<gameList>\n";
+
+		const int systemGames = gameCount / systemCount + (s < gameCount % systemCount ? 1 : 0);
+		int       folderGames = 0;
+		int       folderIndex = 0;
+		for(int g = 0; g < systemGames; g++, gameIndex++)
+		{
+			std::string relativePath = ".";
+
+			if(percent(random) < 10)
+			{
+				if(folderGames++ % GAMES_PER_FOLDER == 0)
+				{
+					std::stringstream folder;
+					folder << "Folder " << ++folderIndex;
+					Utils::FileSystem::createDirectory(romPath + "/" + folder.str());
+
+					gamelist << "\t<folder>\n"
+					         << "\t\t<path>./" << folder.str() << "</path>\n"
+					         << "\t\t<name>" << folder.str() << "</name>\n"
+					         << "\t</folder>\n";
+				}
+
+				std::stringstream folder;
+				folder << "./Folder " << folderIndex;
+				relativePath = folder.str();
+			}
+
+			const std::string gameName = makeGameName(random, gameIndex);
+			relativePath += "/" + gameName + ".zip";
+
+			std::ofstream rom((romPath + "/" + relativePath.substr(2)).c_str(), std::ios::out | std::ios::trunc);
+			rom.close();
+
+			// every game that's in the gamelist carries the metadata a scraper would leave behind
+			if(percent(random) < 90)
+			{
+				gamelist << "\t<game>\n"
+				         << "\t\t<path>" << relativePath << "</path>\n"
+				         << "\t\t<name>" << gameName << "</name>\n"
+				         << "\t\t<desc>Synthetic benchmark entry " << gameIndex << ".</desc>\n"
+				         << "\t\t<rating>" << (rating(random) / 10.0f) << "</rating>\n"
+				         << "\t\t<releasedate>" << makeDate(random, 1980, 2005) << "</releasedate>\n"
+				         << "\t\t<developer>" << companies[company(random)] << "</developer>\n"
+				         << "\t\t<publisher>" << companies[company(random)] << "</publisher>\n"
+				         << "\t\t<genre>" << genres[genre(random)] << "</genre>\n"
+				         << "\t\t<players>" << players(random) << "</players>\n";
+
+				if(percent(random) < 5)
+					gamelist << "\t\t<favorite>true</favorite>\n";
+				if(percent(random) < 2)
+					gamelist << "\t\t<hidden>true</hidden>\n";
+				if(percent(random) < 20)
+					gamelist << "\t\t<kidgame>true</kidgame>\n";
+				if(percent(random) < 10)
+					gamelist << "\t\t<playcount>" << playcount(random) << "</playcount>\n"
+					         << "\t\t<lastplayed>" << makeDate(random, 2015, 2020) << "</lastplayed>\n";
+
+				gamelist << "\t</game>\n";
+			}
+		}
+
+		gamelist << "</gameList>\n";
+		gamelist.close();
+	}
+
+	config << "</systemList>\n";
+	config.close();
+
+	return !config.fail();
+}
+
+static void unloadCollections(Window* window)
+{
+	// the manager doesn't delete its auto collections, only removes them from the system list
+	std::map<std::string, CollectionSystemData> autoCollections = CollectionSystemManager::get()->getAutoCollectionSystems();
+	CollectionSystemManager::deinit();
+
+	for(auto it = autoCollections.cbegin(); it != autoCollections.cend(); it++)
+		delete it->second.system;
+
+	CollectionSystemManager::init(window);
+}
+
+static void unloadSystems(Window* window)
+{
+	unloadCollections(window);
+	SystemData::deleteSystems();
+}
+
+static Timing& addTiming(ScaleResult& result, const std::string& name)
+{
+	result.timings.push_back(Timing());
+	result.timings.back().name = name;
+	return result.timings.back();
+}
+
+// setup runs before every sample without being timed
+template<typename Setup, typename Function>
+static void measure(Timing& timing, int repeat, Setup setup, Function function)
+{
+	for(int i = 0; i < repeat; i++)
+	{
+		setup();
+
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		function();
+		timing.samples.push_back(elapsedMs(start));
+	}
+
+	std::cout << "  " << std::left << std::setw(40) << timing.name << std::right << std::fixed << std::setprecision(2)
+	          << *std::min_element(timing.samples.cbegin(), timing.samples.cend()) << " ms" << std::endl;
+}
+
+template<typename Function>
+static void measure(Timing& timing, int repeat, Function function)
+{
+	measure(timing, repeat, [] {}, function);
+}
+
+static ScaleResult runScale(Window* window, const BenchOptions& options, int gameCount)
+{
+	ScaleResult result;
+	result.games = gameCount;
+	result.files = 0;
+	result.treeBytes = 0;
+
+	std::stringstream dir;
+	dir << options.dir << "/" << options.systems << "x" << gameCount;
+
+	const std::string configPath = dir.str() + "/.emulationstation/es_systems.cfg";
+	if(!Utils::FileSystem::exists(configPath))
+	{
+		std::cout << "Generating " << gameCount << " games in " << dir.str() << std::endl;
+		if(!generateData(dir.str(), options.systems, gameCount))
+			std::cerr << "Could not write " << configPath << std::endl;
+
+		Utils::FileSystem::forgetExists(configPath);
+	}
+
+	// es_systems.cfg, gamelist caches and collections are all looked up below the home path
+	Utils::FileSystem::setHomePath(dir.str());
+
+	std::cout << "Benchmarking " << gameCount << " games" << std::endl;
+
+	const Utils::FileSystem::CacheStats pathCacheStart = Utils::FileSystem::getCacheStats();
+
+	Settings* settings = Settings::getInstance();
+	settings->setString("CollectionSystemsAuto", "");
+	settings->setString("CollectionSystemsCustom", "");
+
+	settings->setBool("GamelistCache", false);
+	unloadSystems(window);
+	const size_t heapBefore = getHeapUsage();
+	measure(addTiming(result, "load systems"), options.repeat, [window]
+	{
+		unloadSystems(window);
+		SystemData::loadConfig(nullptr);
+	});
+
+	const size_t heapAfter = getHeapUsage();
+	if(heapAfter > heapBefore)
+		result.treeBytes = heapAfter - heapBefore;
+
+	// the first load writes the snapshots that the following ones read
+	settings->setBool("GamelistCache", true);
+	unloadSystems(window);
+	SystemData::loadConfig(nullptr);
+	measure(addTiming(result, "load systems (gamelist cache)"), options.repeat, [window]
+	{
+		unloadSystems(window);
+		SystemData::loadConfig(nullptr);
+	});
+
+	measure(addTiming(result, "delete systems"), options.repeat, []
+	{
+		SystemData::loadConfig(nullptr);
+	}, []
+	{
+		SystemData::deleteSystems();
+	});
+
+	SystemData::loadConfig(nullptr);
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		result.files += (int)(*it)->getRootFolder()->getFilesRecursive(GAME).size();
+
+	measure(addTiming(result, "parseGamelist"), options.repeat, []
+	{
+		for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+			parseGamelist(*it);
+	});
+
+	// the folders keep every sort order and only move what changed since, loading the metadata again changes all
+	// of it so every sample sorts from scratch
+	for(auto sortIt = FileSorts::SortTypes.cbegin(); sortIt != FileSorts::SortTypes.cend(); sortIt++)
+	{
+		const FileData::SortType& sortType = *sortIt;
+		measure(addTiming(result, "sort " + sortType.description), options.repeat, []
+		{
+			for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+				parseGamelist(*it);
+		}, [&sortType]
+		{
+			for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+				(*it)->getRootFolder()->sort(sortType);
+		});
+	}
+
+	std::vector<FileData*> games;
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+	{
+		std::vector<FileData*> systemGames = (*it)->getRootFolder()->getFilesRecursive(GAME);
+		games.insert(games.cend(), systemGames.cbegin(), systemGames.cend());
+	}
+
+	std::vector<std::string> genreFilter = { "PLATFORM", "SHOOTER" };
+	std::vector<std::string> favoritesFilter = { "TRUE" };
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		(*it)->getIndex()->setFilter(GENRE_FILTER, &genreFilter);
+
+	int shown = 0;
+	measure(addTiming(result, "showFile genre"), options.repeat, [&games, &shown]
+	{
+		shown = 0;
+		for(auto it = games.cbegin(); it != games.cend(); it++)
+			shown += (*it)->getSystem()->getIndex()->showFile(*it) ? 1 : 0;
+	});
+
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		(*it)->getIndex()->setFilter(FAVORITES_FILTER, &favoritesFilter);
+
+	measure(addTiming(result, "showFile genre + favorites"), options.repeat, [&games, &shown]
+	{
+		shown = 0;
+		for(auto it = games.cbegin(); it != games.cend(); it++)
+			shown += (*it)->getSystem()->getIndex()->showFile(*it) ? 1 : 0;
+	});
+
+	// what the system carousel asks for every system when it is populated
+	unsigned int displayed = 0;
+	measure(addTiming(result, "displayed game counts"), options.repeat, [&displayed]
+	{
+		displayed = 0;
+		for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+			displayed += (*it)->getDisplayedGameCount();
+	});
+
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		(*it)->getIndex()->resetFilters();
+
+	measure(addTiming(result, "build search index"), options.repeat, []
+	{
+		GameSearchIndex::deinit();
+		GameSearchIndex::init();
+		GameSearchIndex::getInstance()->waitUntilReady();
+	});
+
+	// a query typed one key at a time, searched again after every key
+	const std::vector<std::string> queries = { "s", "su", "sup", "supe", "super", "super n", "super ni", "super nin" };
+	size_t found = 0;
+	measure(addTiming(result, "search 8 keystrokes"), options.repeat, [&queries, &found]
+	{
+		found = 0;
+		for(auto it = queries.cbegin(); it != queries.cend(); it++)
+			found += GameSearchIndex::getInstance()->search(*it, 50).size();
+	});
+
+	GameSearchIndex::deinit();
+
+	settings->setString("CollectionSystemsAuto", "all,favorites,recent,random");
+	measure(addTiming(result, "populate collections"), options.repeat, [window]
+	{
+		unloadCollections(window);
+		CollectionSystemManager::get()->loadCollectionSystems();
+	});
+
+	unloadCollections(window);
+	settings->setString("CollectionSystemsAuto", "");
+
+	// every game changed is the worst case for a save
+	for(auto it = games.cbegin(); it != games.cend(); it++)
+		(*it)->metadata.set("playcount", (*it)->metadata.get("playcount"));
+
+	measure(addTiming(result, "updateGamelist"), options.repeat, []
+	{
+		for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+			updateGamelist(*it);
+		flushGamelistWrites();
+	});
+
+	result.pathCache         = Utils::FileSystem::getCacheStats();
+	result.pathCache.hits   -= pathCacheStart.hits;
+	result.pathCache.misses -= pathCacheStart.misses;
+
+	unloadSystems(window);
+
+	return result;
+}
+
+static std::string escape(const std::string& _string)
+{
+	return Utils::String::replace(Utils::String::replace(_string, "\\", "\\\\"), "\"", "\\\"");
+}
+
+static bool writeResults(const BenchOptions& options, const std::vector<ScaleResult>& results)
+{
+	std::ofstream file(options.output.c_str(), std::ios::out | std::ios::trunc);
+	if(!file.is_open())
+		return false;
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\n"
+	     << "\t\"version\": \"" << PROGRAM_VERSION_STRING << "\",\n"
+	     << "\t\"built\": \"" << PROGRAM_BUILT_STRING << "\",\n"
+	     << "\t\"systems\": " << options.systems << ",\n"
+	     << "\t\"repeat\": " << options.repeat << ",\n"
+	     << "\t\"results\": [";
+
+	for(auto resultIt = results.cbegin(); resultIt != results.cend(); resultIt++)
+	{
+		file << (resultIt == results.cbegin() ? "\n" : ",\n")
+		     << "\t\t{\n"
+		     << "\t\t\t\"games\": " << resultIt->games << ",\n"
+		     << "\t\t\t\"loaded\": " << resultIt->files << ",\n"
+		     << "\t\t\t\"treeBytes\": " << resultIt->treeBytes << ",\n"
+		     << "\t\t\t\"bytesPerGame\": " << (resultIt->files ? resultIt->treeBytes / resultIt->files : 0) << ",\n"
+		     << "\t\t\t\"pathCache\": { \"entries\": " << resultIt->pathCache.entries << ", \"hits\": " << resultIt->pathCache.hits
+		     << ", \"misses\": " << resultIt->pathCache.misses << " },\n"
+		     << "\t\t\t\"timings\": {";
+
+		for(auto timingIt = resultIt->timings.cbegin(); timingIt != resultIt->timings.cend(); timingIt++)
+		{
+			const std::vector<double>& samples = timingIt->samples;
+			double total = 0;
+			for(auto it = samples.cbegin(); it != samples.cend(); it++)
+				total += *it;
+
+			file << (timingIt == resultIt->timings.cbegin() ? "\n" : ",\n")
+			     << "\t\t\t\t\"" << escape(timingIt->name) << "\": { "
+			     << "\"min\": " << *std::min_element(samples.cbegin(), samples.cend()) << ", "
+			     << "\"mean\": " << (total / samples.size()) << ", "
+			     << "\"max\": " << *std::max_element(samples.cbegin(), samples.cend()) << " }";
+		}
+
+		file << "\n\t\t\t}\n\t\t}";
+	}
+
+	file << "\n\t]\n}\n";
+	file.close();
+
+	return !file.fail();
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	options.games   = { 1000, 10000, 50000, 200000 };
+	options.systems = 10;
+	options.repeat  = 5;
+	options.dir     = Utils::FileSystem::getCWDPath() + "/es-bench-data";
+	options.output  = Utils::FileSystem::getCWDPath() + "/es-bench.json";
+
+	if(!parseArgs(argc, argv, options))
+		return 1;
+
+	// settings and the log live in the data directory, never in the real home
+	Utils::FileSystem::setHomePath(options.dir);
+	Utils::FileSystem::createDirectory(options.dir + "/.emulationstation");
+
+	Log::init();
+	Log::open();
+	Log::setReportingLevel(LogWarning);
+
+	Settings* settings = Settings::getInstance();
+	settings->setString("SaveGamelistsMode", "never");
+	settings->setBool("LazyGamelistViews", true);
+	settings->setBool("WatchRomFolders", false);
+	settings->setBool("ParseGamelistOnly", false);
+	settings->setBool("IgnoreGamelist", false);
+
+	// only what the data layer needs, the window stays uninitialised
+	Window window;
+	ViewController::init(&window);
+	CollectionSystemManager::init(&window);
+	MameNames::init();
+
+	std::vector<ScaleResult> results;
+	for(auto it = options.games.cbegin(); it != options.games.cend(); it++)
+		results.push_back(runScale(&window, options, *it));
+
+	CollectionSystemManager::deinit();
+	MameNames::deinit();
+
+	const bool written = writeResults(options, results);
+	if(written)
+		std::cout << "Results written to " << options.output << std::endl;
+	else
+		std::cerr << "Could not write results to " << options.output << std::endl;
+
+	Log::close();
+
+	return written ? 0 : 1;
+}
@@ -0,0 +1,320 @@
+// ============================================================================
+//  GuiGameSearch.cpp
+//
+//  Search-as-you-type over GameSearchIndex. The query field and the results
+//  are drawn in one panel above the on-screen keyboard, the results take
+//  over the dpad once they're focused.
+// ============================================================================
+#include "guis/GuiGameSearch.h"
+#include "SAStyle.h"
+
+#include "resources/Font.h"
+#include "renderers/Renderer.h"
+#include "utils/StringUtil.h"
+#include "views/gamelist/IGameListView.h"
+#include "views/ViewController.h"
+#include "FileData.h"
+#include "GameSearchIndex.h"
+#include "SystemData.h"
+#include "Window.h"
+
+#define MAX_RESULTS 50
+#define PANEL_PADDING 12.0f
+#define PANEL_GAP 8.0f
+
+GuiGameSearch::GuiGameSearch(Window* window)
+	: GuiComponent(window),
+	  mWaitingForIndex(false),
+	  mResultsFocused(false),
+	  mCursor(0),
+	  mScroll(0),
+	  mVisibleRows(0),
+	  mCursorBlink(0),
+	  mTitleFont(saFont(FONT_SIZE_MEDIUM)),
+	  mTextFont(saFont(FONT_SIZE_LARGE)),
+	  mResultFont(saFont(FONT_SIZE_SMALL)),
+	  mKeyboard(window)
+{
+	float sw = (float)Renderer::getScreenWidth();
+	float sh = (float)Renderer::getScreenHeight();
+	setSize(sw, sh);
+
+	// Keyboard sizing — same as GuiTextInput, anchored to bottom
+	float kbWidth = sw * 0.88f;
+	float kbX = (sw - kbWidth) / 2.0f;
+	mKeyboard.setSize(kbWidth, 0);  // height auto-calculated
+	float kbY = sh - mKeyboard.getSize().y() - sh * 0.03f;
+	mKeyboard.setPosition(kbX, kbY);
+
+	// Panel fills what's left above the legend, the results get whatever the title and field don't use
+	float legendY = kbY - saFont(FONT_SIZE_SMALL)->getHeight() - 10.0f;
+	mPanelY = sh * 0.04f;
+	mPanelHeight = legendY - 10.0f - mPanelY;
+	mResultsY = mPanelY + PANEL_PADDING + mTitleFont->getHeight() + PANEL_GAP + mTextFont->getHeight() * 1.6f + PANEL_GAP;
+	mRowHeight = mResultFont->getHeight() * 1.4f;
+	mVisibleRows = Math::max(1, (int)((mPanelY + mPanelHeight - PANEL_PADDING - mResultsY) / mRowHeight));
+
+	mKeyboard.setOnCharTyped([this](const std::string& ch) {
+		mQuery += ch;
+		updateResults();
+	});
+
+	mKeyboard.setOnBackspace([this]() {
+		if (!mQuery.empty())
+		{
+			size_t newLen = mQuery.length();
+			while (newLen > 0 && (mQuery[newLen - 1] & 0xC0) == 0x80)
+				newLen--;
+			if (newLen > 0)
+				newLen--;
+			mQuery = mQuery.substr(0, newLen);
+		}
+		updateResults();
+	});
+
+	mKeyboard.setOnSubmit([this]() {
+		if (!mResults.empty())
+			setResultsFocused(true);
+	});
+
+	mKeyboard.setOnCancel([this]() {
+		delete this;
+	});
+
+	updateResults();
+}
+
+void GuiGameSearch::updateResults()
+{
+	GameSearchIndex* index = GameSearchIndex::getInstance();
+
+	mResults.clear();
+	mWaitingForIndex = false;
+
+	std::string status;
+	if (index == NULL || !index->isReady())
+	{
+		mWaitingForIndex = true;
+		status = "BUILDING SEARCH INDEX...";
+	}
+	else if (!Utils::String::trim(mQuery).empty())
+	{
+		mResults = index->search(mQuery, MAX_RESULTS);
+		if (mResults.empty())
+			status = "NO GAMES FOUND";
+		else if (mResults.size() == MAX_RESULTS)
+			status = "TOP " + std::to_string(MAX_RESULTS) + " GAMES";
+		else
+			status = std::to_string(mResults.size()) + (mResults.size() == 1 ? " GAME" : " GAMES");
+	}
+
+	mStatusCache = std::unique_ptr<TextCache>(mResultFont->buildTextCache(status, 0, 0, 0x888888FF));
+
+	mNameCaches.clear();
+	mSystemCaches.clear();
+	for (auto it = mResults.cbegin(); it != mResults.cend(); ++it)
+	{
+		mNameCaches.push_back(std::unique_ptr<TextCache>(mResultFont->buildTextCache(Utils::String::toUpper((*it)->getName()), 0, 0, SA_TEXT_COLOR)));
+		mSystemCaches.push_back(std::unique_ptr<TextCache>(mResultFont->buildTextCache(Utils::String::toUpper((*it)->getSystem()->getFullName()), 0, 0, 0x888888FF)));
+	}
+
+	mCursor = 0;
+	mScroll = 0;
+	if (mResults.empty() && mResultsFocused)
+		setResultsFocused(false);
+}
+
+void GuiGameSearch::setResultsFocused(bool focused)
+{
+	mResultsFocused = focused;
+	updateHelpPrompts();
+}
+
+void GuiGameSearch::openSelectedGame()
+{
+	FileData* game = mResults.at(mCursor);
+
+	// the rom watcher keeps running while searching, the game may have been deleted since the results were found
+	GameSearchIndex* searchIndex = GameSearchIndex::getInstance();
+	if (searchIndex == NULL || !searchIndex->contains(game))
+	{
+		updateResults();
+		return;
+	}
+
+	SystemData* system = game->getSystem();
+
+	delete this;
+
+	ViewController::get()->goToGameList(system);
+	ViewController::get()->getGameListView(system)->setCursor(game);
+}
+
+bool GuiGameSearch::input(InputConfig* config, Input input)
+{
+	if (!mResultsFocused)
+		return mKeyboard.input(config, input);
+
+	if (input.value == 0)
+		return true;
+
+	if (config->isMappedLike("up", input))
+	{
+		// above the first result is the keyboard again
+		if (mCursor > 0)
+			mCursor--;
+		else
+			setResultsFocused(false);
+	}
+	else if (config->isMappedLike("down", input))
+	{
+		if (mCursor < (int)mResults.size() - 1)
+			mCursor++;
+	}
+	else if (config->isMappedTo("a", input))
+	{
+		openSelectedGame();
+		return true;
+	}
+	else if (config->isMappedTo("b", input))
+	{
+		setResultsFocused(false);
+	}
+
+	if (mCursor < mScroll)
+		mScroll = mCursor;
+	else if (mCursor >= mScroll + mVisibleRows)
+		mScroll = mCursor - mVisibleRows + 1;
+
+	return true;
+}
+
+void GuiGameSearch::update(int deltaTime)
+{
+	mCursorBlink += deltaTime;
+	if (mCursorBlink > 1000) mCursorBlink -= 1000;
+
+	if (mWaitingForIndex && GameSearchIndex::getInstance() != NULL && GameSearchIndex::getInstance()->isReady())
+		updateResults();
+
+	GuiComponent::update(deltaTime);
+}
+
+void GuiGameSearch::render(const Transform4x4f& parentTrans)
+{
+	Transform4x4f trans = parentTrans * getTransform();
+
+	float sw = mSize.x();
+	float sh = mSize.y();
+
+	// 1. Full-screen dim overlay
+	Renderer::setMatrix(trans);
+	Renderer::drawRect(0.0f, 0.0f, sw, sh, 0x000000D0, 0x000000D0);
+
+	// Use same X and width as the keyboard so they line up
+	float panelX = mKeyboard.getPosition().x();
+	float panelW = mKeyboard.getSize().x();
+	float contentX = panelX + PANEL_PADDING;
+	float contentW = panelW - PANEL_PADDING * 2.0f;
+
+	// 2. Panel background
+	Renderer::drawRect(panelX, mPanelY, panelW, mPanelHeight, 0x1A1A1AFF, 0x1A1A1AFF);
+
+	// 3. Title, status on the right
+	float curY = mPanelY + PANEL_PADDING;
+	{
+		auto titleCache = std::unique_ptr<TextCache>(mTitleFont->buildTextCache("SEARCH GAMES", 0, 0, SA_TEXT_COLOR));
+		Transform4x4f titleTrans = trans;
+		titleTrans.translate(Vector3f(contentX, curY, 0));
+		Renderer::setMatrix(titleTrans);
+		mTitleFont->renderTextCache(titleCache.get());
+	}
+	if (mStatusCache)
+	{
+		Transform4x4f statusTrans = trans;
+		statusTrans.translate(Vector3f(contentX + contentW - mStatusCache->metrics.size.x(), curY + (mTitleFont->getHeight() - mStatusCache->metrics.size.y()) / 2.0f, 0));
+		Renderer::setMatrix(statusTrans);
+		mResultFont->renderTextCache(mStatusCache.get());
+	}
+	curY += mTitleFont->getHeight() + PANEL_GAP;
+
+	// 4. Query field, the cursor only blinks while typing
+	float fieldH = mTextFont->getHeight() * 1.6f;
+	Renderer::setMatrix(trans);
+	Renderer::drawRect(contentX, curY, contentW, fieldH, 0x333333FF, 0x333333FF);
+	Renderer::drawRect(contentX, curY, contentW, 2.0f, 0x555555FF, 0x555555FF);
+	Renderer::drawRect(contentX, curY + fieldH - 2.0f, contentW, 2.0f, 0x555555FF, 0x555555FF);
+	Renderer::drawRect(contentX, curY, 2.0f, fieldH, 0x555555FF, 0x555555FF);
+	Renderer::drawRect(contentX + contentW - 2.0f, curY, 2.0f, fieldH, 0x555555FF, 0x555555FF);
+	{
+		std::string display = mQuery;
+		if (!mResultsFocused && mCursorBlink < 500)
+			display += "|";
+
+		auto textCache = std::unique_ptr<TextCache>(mTextFont->buildTextCache(display, 0, 0, 0xFFFFFFFF));
+		Transform4x4f textTrans = trans;
+		textTrans.translate(Vector3f(contentX + 10.0f, curY + (fieldH - textCache->metrics.size.y()) / 2.0f, 0));
+		Renderer::setMatrix(textTrans);
+		mTextFont->renderTextCache(textCache.get());
+	}
+
+	// 5. Results, name on the left and system on the right
+	for (int row = 0; row < mVisibleRows && mScroll + row < (int)mResults.size(); row++)
+	{
+		const int i = mScroll + row;
+		float rowY = mResultsY + row * mRowHeight;
+
+		if (mResultsFocused && i == mCursor)
+		{
+			Renderer::setMatrix(trans);
+			Renderer::drawRect(contentX, rowY, contentW, mRowHeight, 0x333333FF, 0x333333FF);
+			Renderer::drawRect(contentX, rowY, 2.0f, mRowHeight, SA_SELECTOR_EDGE_COLOR, SA_SELECTOR_EDGE_COLOR);
+			Renderer::drawRect(contentX + contentW - 2.0f, rowY, 2.0f, mRowHeight, SA_SELECTOR_EDGE_COLOR, SA_SELECTOR_EDGE_COLOR);
+		}
+
+		TextCache* systemCache = mSystemCaches[i].get();
+		float systemX = contentX + contentW - 10.0f - systemCache->metrics.size.x();
+		float textY = rowY + (mRowHeight - mResultFont->getHeight()) / 2.0f;
+
+		Renderer::pushClipRect(Vector2i((int)(trans.translation().x() + contentX), (int)(trans.translation().y() + rowY)),
+			Vector2i((int)(systemX - contentX - 20.0f), (int)mRowHeight));
+		Transform4x4f nameTrans = trans;
+		nameTrans.translate(Vector3f(contentX + 10.0f, textY, 0));
+		Renderer::setMatrix(nameTrans);
+		mResultFont->renderTextCache(mNameCaches[i].get());
+		Renderer::popClipRect();
+
+		Transform4x4f systemTrans = trans;
+		systemTrans.translate(Vector3f(systemX, textY, 0));
+		Renderer::setMatrix(systemTrans);
+		mResultFont->renderTextCache(systemCache);
+	}
+
+	// 6. Button legend — centered between panel and keyboard
+	{
+		auto smallFont = saFont(FONT_SIZE_SMALL);
+		std::string legend = mResultsFocused ? "A:GO TO GAME  B:BACK TO KEYBOARD" : "A:TYPE  B:DELETE  Y:RESULTS  X:CANCEL  L/R:LAYOUT";
+		auto legendCache = std::unique_ptr<TextCache>(smallFont->buildTextCache(legend, 0, 0, 0x888888FF));
+		float legendX = (sw - legendCache->metrics.size.x()) / 2.0f;
+		float legendY = mPanelY + mPanelHeight + 10.0f;
+		Transform4x4f legendTrans = trans;
+		legendTrans.translate(Vector3f(legendX, legendY, 0));
+		Renderer::setMatrix(legendTrans);
+		smallFont->renderTextCache(legendCache.get());
+	}
+
+	// 7. Render keyboard manually
+	mKeyboard.render(trans);
+}
+
+std::vector<HelpPrompt> GuiGameSearch::getHelpPrompts()
+{
+	if (!mResultsFocused)
+		return mKeyboard.getHelpPrompts();
+
+	std::vector<HelpPrompt> prompts;
+	prompts.push_back(HelpPrompt("up/down", "choose"));
+	prompts.push_back(HelpPrompt("a", "go to game"));
+	prompts.push_back(HelpPrompt("b", "back"));
+	return prompts;
+}
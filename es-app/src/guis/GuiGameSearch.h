@@ -0,0 +1,65 @@
+// ============================================================================
+//  GuiGameSearch.h
+//
+//  Full-screen search across the games of all systems. Results are updated
+//  with every key typed on the on-screen keyboard, Y (or ENTER) moves to the
+//  results and A jumps to the selected game in its gamelist.
+// ============================================================================
+#pragma once
+#ifndef ES_APP_GUIS_GUI_GAME_SEARCH_H
+#define ES_APP_GUIS_GUI_GAME_SEARCH_H
+
+#include "GuiComponent.h"
+#include "components/OnScreenKeyboard.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class FileData;
+class Font;
+class TextCache;
+
+class GuiGameSearch : public GuiComponent
+{
+public:
+	GuiGameSearch(Window* window);
+
+	bool input(InputConfig* config, Input input) override;
+	void update(int deltaTime) override;
+	void render(const Transform4x4f& parentTrans) override;
+
+	std::vector<HelpPrompt> getHelpPrompts() override;
+
+private:
+	void updateResults();
+	void setResultsFocused(bool focused);
+	void openSelectedGame();
+
+	std::string mQuery;
+	bool mWaitingForIndex; // the query is searched again once the index is built
+
+	std::vector<FileData*> mResults;
+	std::vector<std::unique_ptr<TextCache>> mNameCaches;
+	std::vector<std::unique_ptr<TextCache>> mSystemCaches;
+	bool mResultsFocused;
+	int mCursor;
+	int mScroll;
+	int mVisibleRows;
+	int mCursorBlink;
+
+	// layout, the panel sits above the keyboard like in GuiTextInput
+	float mPanelY;
+	float mPanelHeight;
+	float mResultsY;
+	float mRowHeight;
+
+	std::shared_ptr<Font> mTitleFont;
+	std::shared_ptr<Font> mTextFont;
+	std::shared_ptr<Font> mResultFont;
+
+	std::unique_ptr<TextCache> mStatusCache;
+
+	OnScreenKeyboard mKeyboard;
+};
+
+#endif // ES_APP_GUIS_GUI_GAME_SEARCH_H
@@ -28,6 +28,7 @@ void GuiGamelistFilter::initializeMenu()
 	row.elements.clear();
 
 	addFiltersToMenu();
+	updateCounts();
 
 	mMenu.addButton("BACK", "back", std::bind(&GuiGamelistFilter::applyFilters, this));
 
@@ -78,10 +79,44 @@ void GuiGamelistFilter::addFiltersToMenu()
 		if (allKeys->size() > 0)
 			mMenu.addWithLabel(menuLabel, optionList);
 
+		optionList->setSelectedChangedCallback(std::bind(&GuiGamelistFilter::updateCounts, this));
 		mFilterOptions[type] = optionList;
 	}
 }
 
+void GuiGamelistFilter::updateCounts()
+{
+	std::vector<FilterDataDecl>& decls = mFilterIndex->getFilterDataDecls();
+
+	// what's selected so far, the filters that aren't in the menu (i.e. kiosk and kid mode) stay as they are
+	std::map<FilterIndexType, std::vector<std::string>> selection;
+	for (std::vector<FilterDataDecl>::const_iterator it = decls.cbegin(); it != decls.cend(); ++it ) {
+		auto option = mFilterOptions.find((*it).type);
+		if (option != mFilterOptions.cend())
+			selection[(*it).type] = option->second->getSelectedObjects();
+		else if (*((*it).filteredByRef))
+			selection[(*it).type] = *((*it).currentFilteredKeys);
+	}
+
+	std::map<FilterIndexType, std::map<std::string, int>> keyCounts;
+	const int numMatching = mFilterIndex->getFilterCounts(selection, keyCounts);
+
+	for (std::vector<FilterDataDecl>::const_iterator it = decls.cbegin(); it != decls.cend(); ++it ) {
+		auto option = mFilterOptions.find((*it).type);
+		if (option == mFilterOptions.cend())
+			continue;
+
+		const std::map<std::string, int>& counts = keyCounts[(*it).type];
+		for (auto key: *((*it).allIndexKeys))
+		{
+			auto count = counts.find(key.first);
+			option->second->setEntryName(key.first, key.first + " (" + std::to_string(count != counts.cend() ? count->second : 0) + ")");
+		}
+	}
+
+	mMenu.setSubtitle(std::to_string(numMatching) + (numMatching == 1 ? " GAME MATCHES" : " GAMES MATCH"), SA_SUBTITLE_COLOR);
+}
+
 void GuiGamelistFilter::applyFilters()
 {
 	std::vector<FilterDataDecl> decls = mFilterIndex->getFilterDataDecls();
@@ -24,6 +24,7 @@ private:
 	void applyFilters();
 	void resetAllFilters();
 	void addFiltersToMenu();
+	void updateCounts();
 
 	std::map<FilterIndexType, std::shared_ptr< OptionListComponent<std::string> >> mFilterOptions;
 
@@ -1,6 +1,7 @@
 #include "GuiGamelistOptions.h"
 #include "SAStyle.h"
 
+#include "guis/GuiGameSearch.h"
 #include "guis/GuiGamelistFilter.h"
 #include "scrapers/Scraper.h"
 #include "views/gamelist/IGameListView.h"
@@ -128,6 +129,13 @@ GuiGamelistOptions::GuiGamelistOptions(Window* window, SystemData* system) : Gui
 		mMenu.addRow(row);
 	}
 
+	// search the games of all systems
+	row.elements.clear();
+	row.addElement(std::make_shared<TextComponent>(mWindow, "SEARCH GAMES", saFont(FONT_SIZE_MEDIUM), SA_TEXT_COLOR), true);
+	row.addElement(makeArrow(mWindow), false);
+	row.makeAcceptInputHandler(std::bind(&GuiGamelistOptions::openGameSearch, this));
+	mMenu.addRow(row);
+
 	std::map<std::string, CollectionSystemData> customCollections = CollectionSystemManager::get()->getCustomCollectionSystems();
 
 	if(UIModeController::getInstance()->isUIModeFull() &&
@@ -290,6 +298,16 @@ void GuiGamelistOptions::openGamelistFilter()
 	mWindow->pushGui(ggf);
 }
 
+void GuiGamelistOptions::openGameSearch()
+{
+	Window* window = mWindow;
+
+	// the search jumps to a gamelist of its own, so this menu is closed first
+	delete this;
+
+	window->pushGui(new GuiGameSearch(window));
+}
+
 void GuiGamelistOptions::recreateCollection()
 {
 	CollectionSystemManager::get()->recreateCollection(mSystem);
@@ -548,15 +566,9 @@ void GuiGamelistOptions::deleteSaveState()
 					FileData* rootFolder = system->getRootFolder();
 					if (rootFolder)
 					{
-						std::vector<FileData*> files = rootFolder->getFilesRecursive(GAME);
-						for (auto* f : files)
-						{
-							if (Utils::FileSystem::getFileName(f->getPath()) == ".donotdelete.entry")
-							{
-								f->metadata.set("hidden", "false");
-								break;
-							}
-						}
+						FileData* placeholder = rootFolder->findFile(GAME, [](FileData* f) { return f->getFileName() == ".donotdelete.entry"; });
+						if (placeholder)
+							placeholder->metadata.set("hidden", "false");
 					}
 
 					// Rebuild the gamelist view so the placeholder appears
@@ -22,6 +22,7 @@ public:
 
 private:
 	void openGamelistFilter();
+	void openGameSearch();
 	bool launchSystemScreenSaver();
 	void openMetaDataEd();
 	void startEditMode();
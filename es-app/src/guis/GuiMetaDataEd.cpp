@@ -19,6 +19,7 @@
 #include "CollectionSystemManager.h"
 #include "FileData.h"
 #include "FileFilterIndex.h"
+#include "GameSearchIndex.h"
 #include "SystemData.h"
 #include "Window.h"
 #include "Log.h"
@@ -217,6 +218,7 @@ void GuiMetaDataEd::save()
 
 	// update respective Collection Entries
 	CollectionSystemManager::get()->refreshCollectionSystems(mScraperParams.game);
+	GameSearchIndex::onGameChanged(mScraperParams.game);
 
 	mScraperParams.system->onMetaDataSavePoint();
 }
@@ -286,34 +286,36 @@ bool GuiNetplayLan::findLocalMatch(LanSession& session)
 		FileData* root = sys->getRootFolder();
 		if (!root) continue;
 
-		std::vector<FileData*> games = root->getFilesRecursive(GAME);
+		std::string remoteFilename = session.romFile;
 
-		for (auto* game : games)
-		{
-			std::string localFilename = Utils::FileSystem::getFileName(game->getPath());
-			std::string remoteFilename = session.romFile;
+		// Extract just the filename if it's a full path
+		size_t lastSlash = remoteFilename.rfind('/');
+		if (lastSlash != std::string::npos)
+			remoteFilename = remoteFilename.substr(lastSlash + 1);
 
-			// Extract just the filename if it's a full path
-			size_t lastSlash = remoteFilename.rfind('/');
-			if (lastSlash != std::string::npos)
-				remoteFilename = remoteFilename.substr(lastSlash + 1);
+		remoteFilename = Utils::String::toLower(remoteFilename);
 
-			if (Utils::String::toLower(localFilename) ==
-			    Utils::String::toLower(remoteFilename))
-			{
-				NetplayGameInfo info = NetplayCore::getGameInfo(game);
-				if (info.safety != NetplaySafety::NONE)
-				{
-					session.hasLocalMatch = true;
-					session.localCorePath = info.corePath;
-					session.localConfigPath = info.configPath;
-					session.localRomPath = info.romPath;
-					session.localSystemName = info.systemName;
-					session.safety = info.safety;
-					return true;
-				}
-			}
-		}
+		// the walk stops at the first match
+		const bool matched = !root->visitFiles(GAME, [&session, &remoteFilename](FileData* game) -> bool
+		{
+			if (Utils::String::toLower(game->getFileName()) != remoteFilename)
+				return true;
+
+			NetplayGameInfo info = NetplayCore::getGameInfo(game);
+			if (info.safety == NetplaySafety::NONE)
+				return true;
+
+			session.hasLocalMatch = true;
+			session.localCorePath = info.corePath;
+			session.localConfigPath = info.configPath;
+			session.localRomPath = info.romPath;
+			session.localSystemName = info.systemName;
+			session.safety = info.safety;
+			return false;
+		});
+
+		if (matched)
+			return true;
 	}
 
 	return false;
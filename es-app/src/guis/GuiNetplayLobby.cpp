@@ -347,11 +347,11 @@ void GuiNetplayLobby::loadCRCDatabase()
 		FileData* root = sys->getRootFolder();
 		if (!root) continue;
 
-		std::vector<FileData*> games = root->getFilesRecursive(GAME);
-		if (games.empty()) continue;
+		FileData* firstGame = root->findFile(GAME, [](FileData*) { return true; });
+		if (!firstGame) continue;
 
 		// Get core info from the first game (all games in a system share the same core)
-		NetplayGameInfo sampleInfo = NetplayCore::getGameInfo(games[0]);
+		NetplayGameInfo sampleInfo = NetplayCore::getGameInfo(firstGame);
 		if (sampleInfo.safety == NetplaySafety::NONE) continue;
 
 		std::string corePath = sampleInfo.corePath;
@@ -425,13 +425,13 @@ bool GuiNetplayLobby::findLocalMatch(LobbySession& session)
 		FileData* root = sys->getRootFolder();
 		if (!root) continue;
 
-		std::vector<FileData*> games = root->getFilesRecursive(GAME);
-
-		for (auto* game : games)
+		// the walk stops at the first game that matches and supports netplay
+		NetplayGameInfo info;
+		FileData* match = root->findFile(GAME, [&session, &info](FileData* game) -> bool
 		{
 			// Skip single-player games (players metadata must be 2+)
 			// If no player data exists, allow it (can't filter)
-			const std::string& playersStr = game->metadata.get("players");
+			const std::string& playersStr = game->metadata.get(META_PLAYERS);
 			if (!playersStr.empty())
 			{
 				int maxPlayers = 1;
@@ -442,29 +442,22 @@ bool GuiNetplayLobby::findLocalMatch(LobbySession& session)
 					maxPlayers = atoi(playersStr.c_str());
 
 				if (maxPlayers < 2)
-					continue;  // Single-player only — skip
+					return false;  // Single-player only — skip
 			}
 
 			// Try matching by filename first (most reliable)
 			if (!session.remoteFilename.empty())
 			{
-				std::string localFilename = Utils::FileSystem::getFileName(game->getPath());
+				std::string localFilename = game->getFileName();
 				std::string remoteFilename = session.remoteFilename;
 
 				// Compare with extensions
 				if (Utils::String::toLower(localFilename) ==
 				    Utils::String::toLower(remoteFilename))
 				{
-					NetplayGameInfo info = NetplayCore::getGameInfo(game);
+					info = NetplayCore::getGameInfo(game);
 					if (info.safety != NetplaySafety::NONE)
-					{
-						session.hasLocalMatch = true;
-						session.localCorePath = info.corePath;
-						session.localConfigPath = info.configPath;
-						session.localRomPath = info.romPath;
-						session.localSystemName = info.systemName;
 						return true;
-					}
 				}
 
 				// Compare without extensions (lobby often strips them)
@@ -478,16 +471,9 @@ bool GuiNetplayLobby::findLocalMatch(LobbySession& session)
 				if (Utils::String::toLower(localStem) ==
 				    Utils::String::toLower(remoteStem))
 				{
-					NetplayGameInfo info = NetplayCore::getGameInfo(game);
+					info = NetplayCore::getGameInfo(game);
 					if (info.safety != NetplaySafety::NONE)
-					{
-						session.hasLocalMatch = true;
-						session.localCorePath = info.corePath;
-						session.localConfigPath = info.configPath;
-						session.localRomPath = info.romPath;
-						session.localSystemName = info.systemName;
 						return true;
-					}
 				}
 			}
 
@@ -496,17 +482,22 @@ bool GuiNetplayLobby::findLocalMatch(LobbySession& session)
 			std::string remoteName = Utils::String::toLower(session.gameName);
 			if (localName == remoteName)
 			{
-				NetplayGameInfo info = NetplayCore::getGameInfo(game);
+				info = NetplayCore::getGameInfo(game);
 				if (info.safety != NetplaySafety::NONE)
-				{
-					session.hasLocalMatch = true;
-					session.localCorePath = info.corePath;
-					session.localConfigPath = info.configPath;
-					session.localRomPath = info.romPath;
-					session.localSystemName = info.systemName;
 					return true;
-				}
 			}
+
+			return false;
+		});
+
+		if (match)
+		{
+			session.hasLocalMatch = true;
+			session.localCorePath = info.corePath;
+			session.localConfigPath = info.configPath;
+			session.localRomPath = info.romPath;
+			session.localSystemName = info.systemName;
+			return true;
 		}
 	}
 
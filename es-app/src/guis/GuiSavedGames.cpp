@@ -176,17 +176,10 @@ void GuiSavedGames::launchSave(const SaveStateDeleteHelper::SaveEntryInfo& entry
 	// Find the FileData for this entry
 	FileData* rootFolder = savestatesSystem->getRootFolder();
 	std::string targetFilename = Utils::FileSystem::getFileName(entry.entryPath);
-	FileData* targetFile = nullptr;
-
-	std::vector<FileData*> allGames = rootFolder->getFilesRecursive(GAME);
-	for (auto* game : allGames)
+	FileData* targetFile = rootFolder->findFile(GAME, [&targetFilename](FileData* game)
 	{
-		if (Utils::FileSystem::getFileName(game->getPath()) == targetFilename)
-		{
-			targetFile = game;
-			break;
-		}
-	}
+		return game->getFileName() == targetFilename;
+	});
 
 	if (!targetFile)
 	{
@@ -311,17 +304,10 @@ void GuiSavedGames::deleteSave(const SaveStateDeleteHelper::SaveEntryInfo& entry
 			// Find and remove the FileData
 			FileData* rootFolder = saveSystem->getRootFolder();
 			std::string targetFilename = Utils::FileSystem::getFileName(entryPath);
-			FileData* targetFile = nullptr;
-
-			std::vector<FileData*> allGames = rootFolder->getFilesRecursive(GAME);
-			for (auto* game : allGames)
+			FileData* targetFile = rootFolder->findFile(GAME, [&targetFilename](FileData* game)
 			{
-				if (Utils::FileSystem::getFileName(game->getPath()) == targetFilename)
-				{
-					targetFile = game;
-					break;
-				}
-			}
+				return game->getFileName() == targetFilename;
+			});
 
 			if (targetFile)
 			{
@@ -362,15 +348,9 @@ void GuiSavedGames::deleteSave(const SaveStateDeleteHelper::SaveEntryInfo& entry
 						FileData* rf = saveSystem->getRootFolder();
 						if (rf)
 						{
-							std::vector<FileData*> files = rf->getFilesRecursive(GAME);
-							for (auto* f : files)
-							{
-								if (Utils::FileSystem::getFileName(f->getPath()) == ".donotdelete.entry")
-								{
-									f->metadata.set("hidden", "false");
-									break;
-								}
-							}
+							FileData* placeholder = rf->findFile(GAME, [](FileData* f) { return f->getFileName() == ".donotdelete.entry"; });
+							if (placeholder)
+								placeholder->metadata.set("hidden", "false");
 						}
 						ViewController::get()->reloadGameListView(saveSystem, false);
 					}
@@ -381,13 +361,13 @@ void GuiSavedGames::deleteSave(const SaveStateDeleteHelper::SaveEntryInfo& entry
 			FileFilterIndex* idx = saveSystem->getIndex();
 			idx->resetIndex();
 			FileData* rf = saveSystem->getRootFolder();
-			std::vector<FileData*> allFiles = rf->getFilesRecursive(GAME);
-			for (auto* game : allFiles)
+			rf->visitFiles(GAME, [idx](FileData* game) -> bool
 			{
 				if (game->metadata.get("hidden").empty())
 					game->metadata.set("hidden", "false");
 				idx->addToIndex(game);
-			}
+				return true;
+			});
 			idx->setUIModeFilters();
 
 			ViewController::get()->reloadSystemListView();
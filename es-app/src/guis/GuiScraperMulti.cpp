@@ -7,6 +7,7 @@
 #include "components/TextComponent.h"
 #include "guis/GuiMsgBox.h"
 #include "views/ViewController.h"
+#include "GameSearchIndex.h"
 #include "Gamelist.h"
 #include "PowerSaver.h"
 #include "SystemData.h"
@@ -115,6 +116,7 @@ void GuiScraperMulti::acceptResult(const ScraperSearchResult& result)
 	ScraperSearchParams& search = mSearchQueue.front();
 
 	search.game->metadata = result.mdl;
+	GameSearchIndex::onGameChanged(search.game);
 	updateGamelist(search.system);
 
 	mSearchQueue.pop();
@@ -82,18 +82,19 @@ std::queue<ScraperSearchParams> GuiScraperStart::getSearches(std::vector<SystemD
 	std::queue<ScraperSearchParams> queue;
 	for(auto sys = systems.cbegin(); sys != systems.cend(); sys++)
 	{
-		std::vector<FileData*> games = (*sys)->getRootFolder()->getFilesRecursive(GAME);
-		for(auto game = games.cbegin(); game != games.cend(); game++)
+		SystemData* system = *sys;
+		system->getRootFolder()->visitFiles(GAME, [&queue, &selector, system](FileData* game) -> bool
 		{
-			if(selector((*sys), (*game)))
+			if(selector(system, game))
 			{
 				ScraperSearchParams search;
-				search.game = *game;
-				search.system = *sys;
+				search.game = game;
+				search.system = system;
 
 				queue.push(search);
 			}
-		}
+			return true;
+		});
 	}
 
 	return queue;
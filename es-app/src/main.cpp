@@ -4,18 +4,22 @@
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
 #include "guis/GuiInfoPopup.h"
-#include "Gamelist.h"
-#include "FileFilterIndex.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/ProfilingUtil.h"
+#include "utils/StringPoolUtil.h"
+#include "utils/ThreadPool.h"
+#include "utils/TraceUtil.h"
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "GameSearchIndex.h"
+#include "Gamelist.h"
 #include "InputManager.h"
 #include "Log.h"
 #include "MameNames.h"
 #include "platform.h"
 #include "PowerSaver.h"
+#include "RomWatcher.h"
 #include "ScraperCmdLine.h"
 #include "Settings.h"
 #include "SystemData.h"
@@ -34,6 +38,8 @@
 #include <FreeImage.h>
 
 bool scrape_cmdline = false;
+bool trace_startup = false;
+std::string trace_startup_path;
 
 bool parseArgs(int argc, char* argv[])
 {
@@ -158,6 +164,12 @@ bool parseArgs(int argc, char* argv[])
 		}else if(strcmp(argv[i], "--scrape") == 0)
 		{
 			scrape_cmdline = true;
+		}else if(strcmp(argv[i], "--trace-startup") == 0)
+		{
+			trace_startup = true;
+			// the file is optional
+			if(i < argc - 1 && argv[i + 1][0] != '-')
+				trace_startup_path = argv[++i];
 		}else if(strcmp(argv[i], "--max-vram") == 0)
 		{
 			int maxVRAM = atoi(argv[i + 1]);
@@ -224,6 +236,8 @@ bool parseArgs(int argc, char* argv[])
 				"                               use 0 for unlimited (p)\n"
 				"--show-hidden-files            show also hidden files of filesystem, no effect\n"
 				"                               if --gamelist-only is also set (p)\n"
+				"--trace-startup [FILE]         write a Chrome trace of the startup to FILE,\n"
+				"                               default ~/.emulationstation/startup_trace.json\n"
 				"--vsync 1|0                    turn vsync on (1) or off (0) (default is on)\n"
 				"\nGeneric switches:\n"
 				"--help, -h                     summon a sentient, angry tuba\n\n"
@@ -265,6 +279,8 @@ bool verifyHomeFolderExists()
 // Returns true if everything is OK,
 bool loadSystemConfigFile(Window* window, const char** errorString)
 {
+	TraceScope("loadSystemConfigFile");
+
 	*errorString = NULL;
 
 	if(!SystemData::loadConfig(window))
@@ -351,12 +367,22 @@ int main(int argc, char* argv[])
 	//always close the log on exit
 	atexit(&onExit);
 
+	if(trace_startup)
+	{
+		if(trace_startup_path.empty())
+			trace_startup_path = Utils::FileSystem::getHomePath() + "/.emulationstation/startup_trace.json";
+
+		Utils::Trace::start(trace_startup_path);
+		Utils::Trace::setThreadName("main");
+	}
+
 	Window window;
 	SystemScreenSaver screensaver(&window);
 	PowerSaver::init();
 	ViewController::init(&window);
 	CollectionSystemManager::init(&window);
 	MameNames::init();
+	Utils::ThreadPool::setSharedThreadCount((size_t)std::max(0, Settings::getInstance()->getInt("WorkerThreads")));
 	window.pushGui(ViewController::get());
 
 	bool splashScreen = Settings::getInstance()->getBool("SplashScreen");
@@ -412,6 +438,19 @@ int main(int argc, char* argv[])
 	// this makes for no delays when accessing content, but a longer startup time
 	ViewController::get()->preload();
 
+	const Utils::FileSystem::CacheStats pathCache = Utils::FileSystem::getCacheStats();
+	LOG(LogInfo) << "Path cache: " << pathCache.entries << " paths, " << pathCache.hits << " hits, " << pathCache.misses << " misses ("
+		<< (pathCache.hits * 100 / std::max<size_t>(1, pathCache.hits + pathCache.misses)) << "% hit rate)";
+
+	const Utils::StringPool::Stats stringPool = Utils::StringPool::getStats();
+	LOG(LogInfo) << "String pool: " << stringPool.strings << " strings, " << (stringPool.bytes / 1024) << " KB";
+
+	// pick up roms and gamelists changed while running
+	RomWatcher::init();
+
+	// built in the background, the first search waits for nothing but gets no results until it's done
+	GameSearchIndex::init();
+
 	if(splashScreen)
 		window.renderLoadingScreen(window.getRestartText("Finished! :)"));
 
@@ -428,6 +467,9 @@ int main(int argc, char* argv[])
 		}
 	}
 
+	// boot is done, the trace is written
+	Utils::Trace::stop();
+
 	int lastTime = SDL_GetTicks();
 	int ps_time = SDL_GetTicks();
 
@@ -512,67 +554,19 @@ int main(int argc, char* argv[])
 			{
 				LOG(LogInfo) << "SA_SAVESTATE: Found savestates system, reloading gamelist";
 
-				// Re-parse gamelist.xml from disk. The watcher already wrote
-				// the new <game> entry and created the .entry file, but ES's
-				// in-memory FileData tree doesn't know about it yet.
-				// parseGamelist() calls findOrCreateFile() which is additive —
-				// it only creates FileData nodes for paths not already in the
-				// tree, so existing entries are untouched.
-				parseGamelist(savestatesSystem);
-
-				// Fully rebuild the filter index for this system.
-				// parseGamelist() creates new FileData entries but does NOT
-				// add them to the filter index. In kiosk mode, the hidden
-				// filter requires hidden="false" explicitly — entries with
-				// no hidden tag get key "UNKNOWN" which fails the filter.
-				// Fix: normalize hidden metadata, rebuild index, re-apply filters.
-				{
-					FileFilterIndex* idx = savestatesSystem->getIndex();
-					idx->resetIndex();
-
-					FileData* root = savestatesSystem->getRootFolder();
-					std::vector<FileData*> allGames = root->getFilesRecursive(GAME);
-					for (auto* game : allGames)
-					{
-						// Ensure every entry has an explicit hidden value.
-						// Entries without <hidden> in gamelist.xml get empty
-						// metadata, which the kiosk filter treats as unknown
-						// and hides. Set to "false" so they pass the filter.
-						if (game->metadata.get("hidden").empty())
-						{
-							game->metadata.set("hidden", "false");
-						}
-						idx->addToIndex(game);
-					}
-
-					idx->setUIModeFilters();
-				}
+				// Merge the new <game> entry the watcher wrote to gamelist.xml
+				// into the in-memory tree. Only new and changed entries are
+				// indexed and pushed to the collections and the gamelist view,
+				// the carousel is rebuilt if the system's visibility changed.
+				RomWatcher::getInstance()->reloadGamelist(savestatesSystem);
 
-				LOG(LogInfo) << "SA_SAVESTATE: After parseGamelist — total games: "
+				LOG(LogInfo) << "SA_SAVESTATE: After reloading gamelist — total games: "
 					<< savestatesSystem->getGameCount()
 					<< ", displayed games: "
 					<< savestatesSystem->getDisplayedGameCount()
 					<< ", isVisible: "
 					<< (savestatesSystem->isVisible() ? "YES" : "NO");
 
-				// Remove the old gamelist view entirely so it's rebuilt fresh.
-				// This avoids stale view state from previous delete/add cycles.
-				ViewController::get()->removeGameListView(savestatesSystem);
-
-				// Rebuild the gamelist view for this system (created fresh)
-				auto gameListView = ViewController::get()->getGameListView(savestatesSystem);
-				if(gameListView)
-				{
-					ViewController::get()->reloadGameListView(gameListView.get(), false);
-				}
-
-				// Always rebuild the system carousel after a savestate refresh.
-				// parseGamelist() may have changed visibility (e.g. placeholder
-				// toggled from visible to hidden), and the carousel needs to
-				// reflect the current set of visible systems.
-				ViewController::get()->reloadSystemListView();
-				LOG(LogInfo) << "SA_SAVESTATE: Gamelist and system carousel reloaded";
-
 				// Show a toast popup so the user knows their save was captured
 				window.setInfoPopup(new GuiInfoPopup(&window,
 					"YOUR GAME WAS SAVED! YOU'LL FIND IT IN THE SAVED GAMES SECTION",
@@ -588,6 +582,8 @@ int main(int argc, char* argv[])
 			}
 		}
 
+		RomWatcher::getInstance()->update();
+
 		if(window.isSleeping())
 		{
 			lastTime = SDL_GetTicks();
@@ -616,9 +612,13 @@ int main(int argc, char* argv[])
 	InputManager::getInstance()->deinit();
 	window.deinit();
 
-	MameNames::deinit();
+	GameSearchIndex::deinit();
 	CollectionSystemManager::deinit();
+	RomWatcher::deinit();
 	SystemData::deleteSystems();
+	MameNames::deinit();
+	flushGamelistWrites();
+	Utils::ThreadPool::deinitShared();
 
 	// call this ONLY when linking with FreeImage as a static library
 #ifdef FREEIMAGE_LIB
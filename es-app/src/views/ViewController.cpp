@@ -7,6 +7,8 @@
 #include "guis/GuiMenu.h"
 #include "guis/GuiInfoPopup.h"
 #include "guis/GuiMusicPopup.h"
+#include "resources/TextureResource.h"
+#include "utils/TraceUtil.h"
 #include "views/gamelist/DetailedGameListView.h"
 #include "views/gamelist/IGameListView.h"
 #include "views/gamelist/GridGameListView.h"
@@ -20,6 +22,16 @@
 #include "SystemData.h"
 #include "Window.h"
 #include "AudioManager.h"
+#include <SDL_timer.h>
+
+// time between two views built ahead of being focused, so input and animations keep running smoothly
+#define PREWARM_INTERVAL 100
+// a view built ahead of time gets this many entries at once, for no more than this many ms per frame
+#define PREWARM_SLICE 256
+#define PREWARM_BUDGET 4
+// how often and after which time without focus gamelist views are considered for eviction
+#define EVICTION_CHECK_INTERVAL 1000
+#define GAMELIST_VIEW_IDLE_TIME 30000
 
 ViewController* ViewController::sInstance = NULL;
 
@@ -36,7 +48,7 @@ void ViewController::init(Window* window)
 }
 
 ViewController::ViewController(Window* window)
-	: GuiComponent(window), mCurrentView(nullptr), mCamera(Transform4x4f::Identity()), mFadeOpacity(0), mLockInput(false)
+	: GuiComponent(window), mCurrentView(nullptr), mPrewarmSystem(NULL), mLastPrewarmTime(0), mLastEvictionCheck(0), mCamera(Transform4x4f::Identity()), mFadeOpacity(0), mLockInput(false)
 {
 	mState.viewing = NOTHING;
 }
@@ -211,7 +223,7 @@ void ViewController::playViewTransition()
 			{
 				// right rollover
 				mLockInput = true;
-				tgt.x() = screenWidth * mGameListViews.size();
+				tgt.x() = screenWidth * SystemData::sSystemVector.size();
 			}
 			else if (-mCamera.translation().x() - tgt.x() <= 2 * -screenWidth)
 			{
@@ -255,6 +267,8 @@ void ViewController::onFileChanged(FileData* file, FileChangeType change)
 	auto it = mGameListViews.find(file->getSystem());
 	if(it != mGameListViews.cend())
 		it->second->onFileChanged(file, change);
+	else if(file->getSystem() == mPrewarmSystem)
+		mPrewarmView->populateListLater(); // the games it listed so far may be gone, start over
 }
 
 void ViewController::launch(FileData* game, Vector3f center)
@@ -331,6 +345,12 @@ void ViewController::removeGameListView(SystemData* system)
 		exists->second.reset();
 		mGameListViews.erase(system);
 	}
+
+	mGameListViewLastUsed.erase(system);
+	mEvictedCursors.erase(system);
+
+	if(system == mPrewarmSystem)
+		cancelPrewarm();
 }
 
 ViewController::GameListViewType ViewController::getGameListViewType()
@@ -351,6 +371,51 @@ ViewController::GameListViewType ViewController::getGameListViewType()
 	return selectedViewType;
 }
 
+// Same result as asking every file for getVideoPath() and getThumbnailPath(), but the metadata of all files is
+// checked before any local art is looked up on disk, which mostly saves the lookups entirely.
+static ViewController::GameListViewType getAutomaticViewType(SystemData* system, bool themeHasVideoView)
+{
+	ViewController::GameListViewType type = ViewController::BASIC;
+	FileData* rootFolder = system->getRootFolder();
+
+	const bool hasVideo = !rootFolder->visitFiles(GAME | FOLDER, [&type, themeHasVideoView](FileData* file) -> bool
+	{
+		if (themeHasVideoView && !file->metadata.get(META_VIDEO).empty())
+			return false;
+
+		if (!file->metadata.get(META_THUMBNAIL).empty() || !file->metadata.get(META_IMAGE).empty())
+			type = ViewController::DETAILED;
+		return true;
+	});
+
+	if (hasVideo)
+		return ViewController::VIDEO;
+
+	if (!Settings::getInstance()->getBool("LocalArt") || (type == ViewController::DETAILED && !themeHasVideoView))
+		return type;
+
+	bool hasLocalVideo = false;
+	rootFolder->visitFiles(GAME | FOLDER, [&type, &hasLocalVideo, themeHasVideoView](FileData* file) -> bool
+	{
+		if (themeHasVideoView && !file->getVideoPath().empty())
+		{
+			hasLocalVideo = true;
+			return false;
+		}
+
+		if (type != ViewController::DETAILED && !file->getThumbnailPath().empty())
+		{
+			type = ViewController::DETAILED;
+			// Don't break out in case any subsequent files have video
+			if (!themeHasVideoView)
+				return false;
+		}
+		return true;
+	});
+
+	return hasLocalVideo ? ViewController::VIDEO : type;
+}
+
 std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* system)
 {
 	//if we already made one, return that one
@@ -358,8 +423,28 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	if(exists != mGameListViews.cend())
 		return exists->second;
 
+	std::shared_ptr<IGameListView> view;
+
+	// one that is still being built ahead of time is needed right now, finish it
+	if(system == mPrewarmSystem)
+	{
+		view = mPrewarmView;
+		cancelPrewarm();
+		while(!view->populateListStep((size_t)-1))
+			continue;
+	}
+	else
+	{
+		view = createGameListView(system, true);
+	}
+
+	addGameListView(system, view);
+	return view;
+}
+
+std::shared_ptr<IGameListView> ViewController::createGameListView(SystemData* system, bool populate)
+{
 	system->getIndex()->setUIModeFilters();
-	//if we didn't, make it, remember it, and return it
 	std::shared_ptr<IGameListView> view;
 
 	bool themeHasVideoView = system->getTheme()->hasView("video");
@@ -368,38 +453,23 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	GameListViewType selectedViewType = getGameListViewType();
 
 	if (selectedViewType == AUTOMATIC)
-	{
-		std::vector<FileData*> files = system->getRootFolder()->getFilesRecursive(GAME | FOLDER);
-		for (auto it = files.cbegin(); it != files.cend(); it++)
-		{
-			if (themeHasVideoView && !(*it)->getVideoPath().empty())
-			{
-				selectedViewType = VIDEO;
-				break;
-			}
-			else if (!(*it)->getThumbnailPath().empty())
-			{
-				selectedViewType = DETAILED;
-				// Don't break out in case any subsequent files have video
-			}
-		}
-	}
+		selectedViewType = getAutomaticViewType(system, themeHasVideoView);
 
 	// Create the view
 	switch (selectedViewType)
 	{
 		case VIDEO:
-			view = std::shared_ptr<IGameListView>(new VideoGameListView(mWindow, system->getRootFolder()));
+			view = std::shared_ptr<IGameListView>(new VideoGameListView(mWindow, system->getRootFolder(), populate));
 			break;
 		case DETAILED:
-			view = std::shared_ptr<IGameListView>(new DetailedGameListView(mWindow, system->getRootFolder()));
+			view = std::shared_ptr<IGameListView>(new DetailedGameListView(mWindow, system->getRootFolder(), populate));
 			break;
 		case GRID:
-			view = std::shared_ptr<IGameListView>(new GridGameListView(mWindow, system->getRootFolder()));
+			view = std::shared_ptr<IGameListView>(new GridGameListView(mWindow, system->getRootFolder(), populate));
 			break;
 		case BASIC:
 		default:
-			view = std::shared_ptr<IGameListView>(new BasicGameListView(mWindow, system->getRootFolder()));
+			view = std::shared_ptr<IGameListView>(new BasicGameListView(mWindow, system->getRootFolder(), populate));
 			break;
 	}
 
@@ -409,10 +479,35 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	int id = (int)(std::find(sysVec.cbegin(), sysVec.cend(), system) - sysVec.cbegin());
 	view->setPosition(id * (float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight() * 2);
 
+	return view;
+}
+
+void ViewController::addGameListView(SystemData* system, const std::shared_ptr<IGameListView>& view)
+{
 	addChild(view.get());
 
+	// put the cursor back where it was before the view got evicted
+	auto evicted = mEvictedCursors.find(system);
+	if(evicted != mEvictedCursors.cend())
+	{
+		const std::string& cursorPath = evicted->second.first;
+		FileData* cursor = system->getRootFolder()->findFile(GAME | FOLDER, [&cursorPath](FileData* file) { return file->hasPath(cursorPath); });
+		if(cursor)
+		{
+			view->setCursor(cursor);
+			view->setViewportTop(evicted->second.second);
+		}
+		mEvictedCursors.erase(evicted);
+	}
+
 	mGameListViews[system] = view;
-	return view;
+	mGameListViewLastUsed[system] = SDL_GetTicks();
+}
+
+void ViewController::cancelPrewarm()
+{
+	mPrewarmSystem = NULL;
+	mPrewarmView.reset();
 }
 
 std::shared_ptr<SystemView> ViewController::getSystemListView()
@@ -472,6 +567,8 @@ bool ViewController::input(InputConfig* config, Input input)
 
 void ViewController::update(int deltaTime)
 {
+	updateGameListViewCache();
+
 	if(mCurrentView)
 	{
 		mCurrentView->update(deltaTime);
@@ -490,6 +587,124 @@ void ViewController::update(int deltaTime)
 	updateSelf(deltaTime);
 }
 
+void ViewController::updateGameListViewCache()
+{
+	if(!Settings::getInstance()->getBool("LazyGamelistViews"))
+		return;
+
+	const int now = SDL_GetTicks();
+
+	SystemData* focused = NULL;
+	if(mState.viewing == GAME_LIST)
+		focused = mState.getSystem();
+	else if(mState.viewing == SYSTEM_SELECT && mSystemListView && mSystemListView->size() > 0)
+		focused = mSystemListView->getSelected();
+
+	if(focused == NULL)
+		return;
+
+	mGameListViewLastUsed[focused] = now;
+
+	// queue the focused system and its neighbours once the focus moved on
+	if(mFocusedSystems.empty() || mFocusedSystems.front() != focused)
+	{
+		mFocusedSystems.clear();
+		mFocusedSystems.push_back(focused);
+		if(focused->isVisible())
+		{
+			mFocusedSystems.push_back(focused->getNext());
+			mFocusedSystems.push_back(focused->getPrev());
+		}
+		mPrewarmQueue = mFocusedSystems;
+	}
+
+	// nothing is built while the camera or the carousel move or a menu is open, one view at a time
+	const bool busy = isAnimationPlaying(0) || (mWindow->peekGui() != this) ||
+		(mSystemListView && (mSystemListView->isScrolling() || mSystemListView->isAnimationPlaying(0)));
+
+	if(!busy && mPrewarmView)
+	{
+		TraceScopeDetail("prewarmGameListView", mPrewarmSystem->getName());
+
+		// fill the list a slice at a time until this frame's share is used up, the rest waits for the next frame
+		bool done = false;
+		while(!done && (int)(SDL_GetTicks() - now) < PREWARM_BUDGET)
+			done = mPrewarmView->populateListStep(PREWARM_SLICE);
+
+		if(done)
+		{
+			SystemData* system = mPrewarmSystem;
+			std::shared_ptr<IGameListView> view = mPrewarmView;
+			cancelPrewarm();
+			addGameListView(system, view);
+			mLastPrewarmTime = SDL_GetTicks();
+		}
+	}
+	else if(!busy && !mPrewarmQueue.empty() && (now - mLastPrewarmTime) >= PREWARM_INTERVAL)
+	{
+		SystemData* system = mPrewarmQueue.front();
+		mPrewarmQueue.erase(mPrewarmQueue.begin());
+
+		// only the empty view is made now, updates to come fill its list
+		if(!hasGameListView(system))
+		{
+			TraceScopeDetail("prewarmGameListView", system->getName());
+			mPrewarmView = createGameListView(system, false);
+			mPrewarmSystem = system;
+			mLastPrewarmTime = SDL_GetTicks();
+		}
+	}
+
+	if(busy || (now - mLastEvictionCheck) < EVICTION_CHECK_INTERVAL)
+		return;
+
+	mLastEvictionCheck = now;
+
+	const int    maxViews   = Settings::getInstance()->getInt("MaxGamelistViews");
+	const size_t maxTexture = (size_t)Settings::getInstance()->getInt("MaxVRAM") * 1024 * 1024;
+
+	// a limit of 0 means no limit, the same as for MaxVRAM
+	while(((maxViews > 0) && ((int)mGameListViews.size() > maxViews)) || ((maxTexture > 0) && (TextureResource::getTotalTextureSize() > maxTexture)))
+	{
+		// least recently focused, idle view that nobody else holds on to
+		SystemData* oldest = NULL;
+		int oldestTime = now;
+		for(auto it = mGameListViews.cbegin(); it != mGameListViews.cend(); it++)
+		{
+			if(it->second.use_count() > 1 || std::find(mFocusedSystems.cbegin(), mFocusedSystems.cend(), it->first) != mFocusedSystems.cend())
+				continue;
+
+			const int lastUsed = mGameListViewLastUsed[it->first];
+			if((now - lastUsed) >= GAMELIST_VIEW_IDLE_TIME && lastUsed <= oldestTime)
+			{
+				oldest = it->first;
+				oldestTime = lastUsed;
+			}
+		}
+
+		if(oldest == NULL)
+			break;
+
+		evictGameListView(oldest);
+	}
+}
+
+void ViewController::evictGameListView(SystemData* system)
+{
+	auto it = mGameListViews.find(system);
+	if(it == mGameListViews.cend())
+		return;
+
+	LOG(LogDebug) << "Evicting gamelist view of " << system->getName();
+
+	FileData* cursor = it->second->getCursor();
+	if(cursor != NULL && !cursor->isPlaceHolder())
+		mEvictedCursors[system] = std::make_pair(cursor->getPath(), it->second->getViewportTop());
+
+	mGameListViews.erase(it);
+	mGameListViewLastUsed.erase(system);
+}
+
 void ViewController::render(const Transform4x4f& parentTrans)
 {
 	Transform4x4f trans = mCamera * parentTrans;
@@ -532,6 +747,19 @@ void ViewController::render(const Transform4x4f& parentTrans)
 
 void ViewController::preload()
 {
+	TraceScope("ViewController::preload");
+
+	if(Settings::getInstance()->getBool("LazyGamelistViews"))
+	{
+		// the filters decide which systems show up in the carousel, so they are needed right away
+		for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
+		{
+			(*it)->getIndex()->resetFilters();
+			(*it)->getIndex()->setUIModeFilters();
+		}
+		return;
+	}
+
 	int i = 1;
 	int max = SystemData::sSystemVector.size() + 1;
 
@@ -549,6 +777,8 @@ void ViewController::preload()
 			mWindow->renderLoadingScreen(loadText, (float)i / (float)max);
 		}
 
+		TraceScopeDetail("getGameListView", (*it)->getName());
+
 		(*it)->getIndex()->resetFilters();
 		getGameListView(*it);
 	}
@@ -599,15 +829,20 @@ void ViewController::reloadAll(bool themeChanged)
 		viewportTopMap[it->first] = it->second->getViewportTop();
 	}
 	mGameListViews.clear();
+	cancelPrewarm();
 
-	// load themes, create gamelistviews and reset filters
-	for(auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
+	// load themes and reset filters of all systems, views that were not built yet will use them later on
+	for(auto it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); it++)
 	{
-		it->first->loadTheme();
-		it->first->getIndex()->resetFilters();
-		getGameListView(it->first)->setCursor(it->second);
+		(*it)->loadTheme();
+		(*it)->getIndex()->resetFilters();
+		(*it)->getIndex()->setUIModeFilters();
 	}
 
+	// create gamelistviews
+	for(auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
+		getGameListView(it->first)->setCursor(it->second);
+
 	if(!themeChanged || !Settings::getInstance()->getBool("UseFullscreenPaging"))
 	{
 		// restore index of first list item on display
@@ -22,6 +22,8 @@ public:
 
 	// Try to completely populate the GameListView map.
 	// Caches things so there's no pauses during transitions.
+	// With LazyGamelistViews only the filters are set up, views are then built when their system is
+	// focused and the neighbours of the focused system are built ahead in the background.
 	void preload();
 
 	// If a basic view detected a metadata change, it can request to recreate
@@ -85,6 +87,7 @@ public:
 	virtual HelpStyle getHelpStyle() override;
 
 	std::shared_ptr<IGameListView> getGameListView(SystemData* system);
+	inline bool hasGameListView(SystemData* system) const { return (mGameListViews.find(system) != mGameListViews.cend()) || (system == mPrewarmSystem); }
 	std::shared_ptr<SystemView> getSystemListView();
 	void removeGameListView(SystemData* system);
 
@@ -95,10 +98,28 @@ private:
 	void playViewTransition();
 	int getSystemId(SystemData* system);
 
+	// Builds the views next to the focused system and evicts idle views under memory pressure,
+	// a little at a time from update().
+	void updateGameListViewCache();
+	void evictGameListView(SystemData* system);
+
+	std::shared_ptr<IGameListView> createGameListView(SystemData* system, bool populate);
+	void addGameListView(SystemData* system, const std::shared_ptr<IGameListView>& view);
+	void cancelPrewarm();
+
 	std::shared_ptr<GuiComponent> mCurrentView;
 	std::map< SystemData*, std::shared_ptr<IGameListView> > mGameListViews;
 	std::shared_ptr<SystemView> mSystemListView;
 
+	std::map< SystemData*, int > mGameListViewLastUsed; // SDL ticks a view was last focused
+	std::map< SystemData*, std::pair<std::string, int> > mEvictedCursors; // cursor path and viewport top of evicted views
+	std::vector<SystemData*> mFocusedSystems; // the focused system and its neighbours, never evicted
+	std::vector<SystemData*> mPrewarmQueue;
+	SystemData* mPrewarmSystem; // the view being built ahead of time, its list is filled a slice per frame
+	std::shared_ptr<IGameListView> mPrewarmView;
+	int mLastPrewarmTime;
+	int mLastEvictionCheck;
+
 	Transform4x4f mCamera;
 	float mFadeOpacity;
 	bool mLockInput;
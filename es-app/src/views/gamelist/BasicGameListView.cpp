@@ -7,7 +7,7 @@
 #include "Settings.h"
 #include "SystemData.h"
 
-BasicGameListView::BasicGameListView(Window* window, FileData* root)
+BasicGameListView::BasicGameListView(Window* window, FileData* root, bool populate)
 	: ISimpleGameListView(window, root), mList(window)
 {
 	mList.setSize(mSize.x(), mSize.y() * 0.8f);
@@ -15,7 +15,10 @@ BasicGameListView::BasicGameListView(Window* window, FileData* root)
 	mList.setDefaultZIndex(20);
 	addChild(&mList);
 
-	populateList(root->getChildrenListToDisplay());
+	if(populate)
+		populateList(root->getChildrenListToDisplay());
+	else
+		populateListLater();
 }
 
 void BasicGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
@@ -39,21 +42,14 @@ void BasicGameListView::onFileChanged(FileData* file, FileChangeType change)
 	ISimpleGameListView::onFileChanged(file, change);
 }
 
-void BasicGameListView::populateList(const std::vector<FileData*>& files)
+void BasicGameListView::clearList()
 {
 	mList.clear();
-	mHeaderText.setText(mRoot->getSystem()->getFullName());
-	if (files.size() > 0)
-	{
-		for(auto it = files.cbegin(); it != files.cend(); it++)
-		{
-			mList.add((*it)->getName(), *it, ((*it)->getType() == FOLDER));
-		}
-	}
-	else
-	{
-		addPlaceholder();
-	}
+}
+
+void BasicGameListView::addToList(FileData* file)
+{
+	mList.add(file->getName(), file, (file->getType() == FOLDER));
 }
 
 FileData* BasicGameListView::getCursor()
@@ -8,7 +8,7 @@
 class BasicGameListView : public ISimpleGameListView
 {
 public:
-	BasicGameListView(Window* window, FileData* root);
+	BasicGameListView(Window* window, FileData* root, bool populate = true);
 
 	// Called when a FileData* is added, has its metadata changed, or is removed
 	virtual void onFileChanged(FileData* file, FileChangeType change) override;
@@ -30,9 +30,10 @@ public:
 protected:
 	virtual std::string getQuickSystemSelectRightButton() override;
 	virtual std::string getQuickSystemSelectLeftButton() override;
-	virtual void populateList(const std::vector<FileData*>& files) override;
+	virtual void clearList() override;
+	virtual void addToList(FileData* file) override;
 	virtual void remove(FileData* game, bool deleteFile, bool refreshView=true) override;
-	virtual void addPlaceholder();
+	virtual void addPlaceholder() override;
 
 	TextListComponent<FileData*> mList;
 };
@@ -4,8 +4,8 @@
 #include "animations/LambdaAnimation.h"
 #include "views/ViewController.h"
 
-DetailedGameListView::DetailedGameListView(Window* window, FileData* root) :
-	BasicGameListView(window, root),
+DetailedGameListView::DetailedGameListView(Window* window, FileData* root, bool populate) :
+	BasicGameListView(window, root, populate),
 	mDescContainer(window, DESCRIPTION_SCROLL_DELAY), mDescription(window),
 	mThumbnail(window),
 	mMarquee(window),
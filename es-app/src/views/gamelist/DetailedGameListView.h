@@ -10,7 +10,7 @@
 class DetailedGameListView : public BasicGameListView
 {
 public:
-	DetailedGameListView(Window* window, FileData* root);
+	DetailedGameListView(Window* window, FileData* root, bool populate = true);
 
 	virtual void onThemeChanged(const std::shared_ptr<ThemeData>& theme) override;
 
@@ -12,7 +12,7 @@
 #endif
 #include "components/VideoVlcComponent.h"
 
-GridGameListView::GridGameListView(Window* window, FileData* root) :
+GridGameListView::GridGameListView(Window* window, FileData* root, bool populate) :
 	ISimpleGameListView(window, root),
 	mGrid(window), mMarquee(window),
 	mImage(window),
@@ -44,7 +44,10 @@ GridGameListView::GridGameListView(Window* window, FileData* root) :
 	mGrid.setCursorChangedCallback([&](const CursorState& /*state*/) { updateInfoPanel(); });
 	addChild(&mGrid);
 
-	populateList(root->getChildrenListToDisplay());
+	if(populate)
+		populateList(root->getChildrenListToDisplay());
+	else
+		populateListLater();
 
 	// metadata labels + values
 	mLblRating.setText("Rating: ");
@@ -171,21 +174,14 @@ const std::string GridGameListView::getImagePath(FileData* file)
 	return file->getThumbnailPath();
 }
 
-void GridGameListView::populateList(const std::vector<FileData*>& files)
+void GridGameListView::clearList()
 {
 	mGrid.clear();
-	mHeaderText.setText(mRoot->getSystem()->getFullName());
-	if (files.size() > 0)
-	{
-		for (auto it = files.cbegin(); it != files.cend(); it++)
-		{
-			mGrid.add((*it)->getName(), getImagePath(*it), *it);
-		}
-	}
-	else
-	{
-		addPlaceholder();
-	}
+}
+
+void GridGameListView::addToList(FileData* file)
+{
+	mGrid.add(file->getName(), getImagePath(file), file);
 }
 
 void GridGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
@@ -232,9 +228,16 @@ void GridGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 	mDescription.applyTheme(theme, getName(), "md_description", ALL ^ (POSITION | ThemeFlags::SIZE | ThemeFlags::ORIGIN | TEXT | ROTATION));
 
 	// Repopulate list in case new theme is displaying a different image.  Preserve selection.
-	FileData* file = mGrid.getSelected();
-	populateList(mRoot->getChildrenListToDisplay());
-	mGrid.setCursor(file);
+	if(isPopulating())
+	{
+		populateListLater();
+	}
+	else
+	{
+		FileData* file = mGrid.getSelected();
+		populateList(mRoot->getChildrenListToDisplay());
+		mGrid.setCursor(file);
+	}
 
 	sortChildren();
 }
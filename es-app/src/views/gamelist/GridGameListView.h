@@ -12,7 +12,7 @@
 class GridGameListView : public ISimpleGameListView
 {
 public:
-	GridGameListView(Window* window, FileData* root);
+	GridGameListView(Window* window, FileData* root, bool populate = true);
 	virtual ~GridGameListView();
 
 	virtual void onShow() override;
@@ -37,9 +37,10 @@ protected:
 	virtual void update(int deltaTime) override;
 	virtual std::string getQuickSystemSelectRightButton() override;
 	virtual std::string getQuickSystemSelectLeftButton() override;
-	virtual void populateList(const std::vector<FileData*>& files) override;
+	virtual void clearList() override;
+	virtual void addToList(FileData* file) override;
 	virtual void remove(FileData* game, bool deleteFile, bool refreshView=true) override;
-	virtual void addPlaceholder();
+	virtual void addPlaceholder() override;
 
 	ImageGridComponent<FileData*> mGrid;
 
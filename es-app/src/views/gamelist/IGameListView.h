@@ -40,6 +40,11 @@ public:
 	virtual bool input(InputConfig* config, Input input) override;
 	virtual void remove(FileData* game, bool deleteFile, bool refreshView=true) = 0;
 
+	// Views built ahead of being focused fill their list over several frames, see ViewController::updateGameListViewCache().
+	// populateListLater() empties the list, populateListStep() adds up to maxEntries entries and returns true once it is complete.
+	virtual void populateListLater() { }
+	virtual bool populateListStep(size_t /*maxEntries*/) { return true; }
+
 	virtual const char* getName() const = 0;
 	virtual void launch(FileData* game) = 0;
 
@@ -7,9 +7,10 @@
 #include "Settings.h"
 #include "Sound.h"
 #include "SystemData.h"
+#include <algorithm>
 
 ISimpleGameListView::ISimpleGameListView(Window* window, FileData* root) : IGameListView(window, root),
-	mHeaderText(window), mHeaderImage(window), mBackground(window)
+	mHeaderText(window), mHeaderImage(window), mBackground(window), mPendingFile(0), mPendingListed(false), mPopulating(false)
 {
 	mHeaderText.setText("Logo Text");
 	mHeaderText.setSize(mSize.x(), 0);
@@ -61,6 +62,67 @@ void ISimpleGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme
 	}
 }
 
+void ISimpleGameListView::populateList(const std::vector<FileData*>& files)
+{
+	// a full populate overrides a list that is still being filled
+	mPendingFiles.clear();
+	mPopulating = false;
+
+	clearList();
+	mHeaderText.setText(mRoot->getSystem()->getFullName());
+	if (files.size() > 0)
+	{
+		for(auto it = files.cbegin(); it != files.cend(); it++)
+			addToList(*it);
+	}
+	else
+	{
+		addPlaceholder();
+	}
+}
+
+void ISimpleGameListView::populateListLater()
+{
+	clearList();
+	mHeaderText.setText(mRoot->getSystem()->getFullName());
+
+	mPendingFiles.clear();
+	mPendingFile = 0;
+	mPendingListed = false;
+	mPopulating = true;
+}
+
+bool ISimpleGameListView::populateListStep(size_t maxEntries)
+{
+	if(!mPopulating)
+		return true;
+
+	// looking up the games to show walks all of them once, that is a step of its own
+	if(!mPendingListed)
+	{
+		mPendingFiles = mRoot->getChildrenListToDisplay();
+		mPendingListed = true;
+		return false;
+	}
+
+	const size_t end = std::min(mPendingFiles.size(), mPendingFile + maxEntries);
+	for(; mPendingFile < end; mPendingFile++)
+		addToList(mPendingFiles[mPendingFile]);
+
+	if(mPendingFile < mPendingFiles.size())
+		return false;
+
+	if(mPendingFiles.empty())
+		addPlaceholder();
+
+	mPendingFiles.clear();
+	mPopulating = false;
+
+	// let the view show the details of the first entry
+	setCursor(getCursor());
+	return true;
+}
+
 void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType /*change*/)
 {
 	// we could be tricky here to be efficient;
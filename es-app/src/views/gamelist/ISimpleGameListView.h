@@ -30,12 +30,20 @@ public:
 	virtual bool input(InputConfig* config, Input input) override;
 	virtual void launch(FileData* game) override = 0;
 
+	virtual void populateListLater() override;
+	virtual bool populateListStep(size_t maxEntries) override;
+
 protected:
 	static const int DESCRIPTION_SCROLL_DELAY = 5 * 1000; // five secs
 
 	virtual std::string getQuickSystemSelectRightButton() = 0;
 	virtual std::string getQuickSystemSelectLeftButton() = 0;
-	virtual void populateList(const std::vector<FileData*>& files) = 0;
+	virtual void populateList(const std::vector<FileData*>& files);
+	virtual void clearList() = 0;
+	virtual void addToList(FileData* file) = 0;
+	virtual void addPlaceholder() = 0;
+
+	inline bool isPopulating() const { return mPopulating; }
 
 	TextComponent mHeaderText;
 	ImageComponent mHeaderImage;
@@ -44,6 +52,12 @@ protected:
 	std::vector<GuiComponent*> mThemeExtras;
 
 	std::stack<FileData*> mCursorStack;
+
+private:
+	std::vector<FileData*> mPendingFiles; // games still to be added by populateListStep()
+	size_t mPendingFile;
+	bool mPendingListed;
+	bool mPopulating;
 };
 
 #endif // ES_APP_VIEWS_GAME_LIST_ISIMPLE_GAME_LIST_VIEW_H
@@ -12,8 +12,8 @@
 #include "Settings.h"
 #endif
 
-VideoGameListView::VideoGameListView(Window* window, FileData* root) :
-	BasicGameListView(window, root),
+VideoGameListView::VideoGameListView(Window* window, FileData* root, bool populate) :
+	BasicGameListView(window, root, populate),
 	mDescContainer(window, DESCRIPTION_SCROLL_DELAY), mDescription(window),
 	mThumbnail(window),
 	mMarquee(window),
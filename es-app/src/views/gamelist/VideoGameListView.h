@@ -12,7 +12,7 @@ class VideoComponent;
 class VideoGameListView : public BasicGameListView
 {
 public:
-	VideoGameListView(Window* window, FileData* root);
+	VideoGameListView(Window* window, FileData* root, bool populate = true);
 	virtual ~VideoGameListView();
 
 	virtual void onShow() override;
@@ -3,7 +3,8 @@
 #define ES_CORE_MAMENAMES_H
 
 #include <string>
-#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 
 class MameNames
 {
@@ -12,30 +13,21 @@ public:
 	static void       init       ();
 	static void       deinit     ();
 	static MameNames* getInstance();
-	std::string       getRealName(const std::string& _mameName);
-	const bool        isBios(const std::string& _biosName);
-	const bool        isDevice(const std::string& _deviceName);
+	std::string       getRealName(const std::string& _mameName) const;
+	const bool        isBios(const std::string& _biosName) const;
+	const bool        isDevice(const std::string& _deviceName) const;
 
 private:
 
-	struct NamePair
-	{
-		std::string mameName;
-		std::string realName;
-	};
-
-	typedef std::vector<NamePair> namePairVector;
-
 	 MameNames();
 	~MameNames();
 
 	static MameNames* sInstance;
 
-	namePairVector mNamePairs;
-	std::vector<std::string> mMameBioses;
-	std::vector<std::string> mMameDevices;
-
-	const bool find(const std::vector<std::string> devices, const std::string& name);
+	// looked up for every file of the arcade systems, a hash beats searching the sorted lists
+	std::unordered_map<std::string, std::string> mRealNames;
+	std::unordered_set<std::string>              mMameBioses;
+	std::unordered_set<std::string>              mMameDevices;
 
 }; // MameNames
 
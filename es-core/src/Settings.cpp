@@ -58,6 +58,10 @@ void Settings::setDefaults()
 
 	mBoolMap["BackgroundJoystickInput"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
+	mBoolMap["GamelistCache"] = true;
+	mBoolMap["MetaDataJournal"] = true;
+	mBoolMap["WatchRomFolders"] = true;
+	mBoolMap["LazyGamelistViews"] = true;
 	mBoolMap["ShowHiddenFiles"] = false;
 	mBoolMap["DrawFramerate"] = false;
 	mBoolMap["ShowExit"] = true;
@@ -80,6 +84,8 @@ void Settings::setDefaults()
 	mBoolMap["MoveCarousel"] = true;
 
 	mBoolMap["ThreadedLoading"] = false;
+	mIntMap["WorkerThreads"] = 0; // 0 == one less than the number of cores
+	mIntMap["MaxGamelistViews"] = 8; // 0 == no limit, idle views beyond it are released
 
 	mBoolMap["Debug"] = false;
 	mBoolMap["DebugGrid"] = false;
@@ -9,6 +9,9 @@
 #include "Settings.h"
 #include <pugixml.hpp>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 std::vector<std::string> ThemeData::sSupportedViews { { "system" }, { "basic" }, { "detailed" }, { "grid" }, { "video" } };
 std::vector<std::string> ThemeData::sSupportedFeatures { { "video" }, { "carousel" }, { "z-index" }, { "visible" } };
@@ -225,6 +228,44 @@ ThemeData::ThemeData()
 	mResolution = { 1, 1 };
 }
 
+// Parsed theme files, shared by every ThemeData that loads or includes them. Placeholders are only resolved
+// while the views are parsed, so the documents don't depend on the system and 40 systems including the same
+// colors, fonts and layouts parse each of them once. A file that changed on disk is parsed again.
+struct CachedThemeDocument
+{
+	time_t                                    modTime;
+	std::shared_ptr<const pugi::xml_document> doc;
+};
+
+static std::mutex                                           sDocumentCacheMutex;
+static std::unordered_map<std::string, CachedThemeDocument> sDocumentCache;
+
+static std::shared_ptr<const pugi::xml_document> loadThemeDocument(const std::string& path, pugi::xml_parse_result& result)
+{
+	const time_t modTime = Utils::FileSystem::getModificationTime(path);
+
+	{
+		std::unique_lock<std::mutex> lock(sDocumentCacheMutex);
+
+		auto it = sDocumentCache.find(path);
+		if(it != sDocumentCache.cend() && it->second.modTime == modTime)
+			return it->second.doc;
+	}
+
+	// parsed without holding the lock, systems loading their themes in parallel don't wait for each other
+	std::shared_ptr<pugi::xml_document> doc = std::make_shared<pugi::xml_document>();
+	result = doc->load_file(path.c_str());
+	if(!result)
+		return nullptr;
+
+	std::unique_lock<std::mutex> lock(sDocumentCacheMutex);
+
+	CachedThemeDocument& cached = sDocumentCache[path];
+	cached.modTime = modTime;
+	cached.doc     = doc;
+	return doc;
+}
+
 void ThemeData::loadFile(std::map<std::string, std::string> sysDataMap, const std::string& path)
 {
 	mPaths.push_back(path);
@@ -242,12 +283,12 @@ void ThemeData::loadFile(std::map<std::string, std::string> sysDataMap, const st
 
 	mVariables.insert(sysDataMap.cbegin(), sysDataMap.cend());
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result res = doc.load_file(path.c_str());
-	if(!res)
+	pugi::xml_parse_result res;
+	std::shared_ptr<const pugi::xml_document> doc = loadThemeDocument(path, res);
+	if(!doc)
 		throw error << "XML parsing error: \n    " << res.description();
 
-	pugi::xml_node root = doc.child("theme");
+	pugi::xml_node root = doc->child("theme");
 	if(!root)
 		throw error << "Missing <theme> tag!";
 
@@ -298,12 +339,12 @@ void ThemeData::parseIncludes(const pugi::xml_node& root)
 
 		mPaths.push_back(path);
 
-		pugi::xml_document includeDoc;
-		pugi::xml_parse_result result = includeDoc.load_file(path.c_str());
-		if(!result)
+		pugi::xml_parse_result result;
+		std::shared_ptr<const pugi::xml_document> includeDoc = loadThemeDocument(path, result);
+		if(!includeDoc)
 			throw error << "Error parsing file: \n    " << result.description();
 
-		pugi::xml_node theme = includeDoc.child("theme");
+		pugi::xml_node theme = includeDoc->child("theme");
 		if(!theme)
 			throw error << "Missing <theme> tag!";
 
@@ -283,6 +283,18 @@ public:
 		onSelectedChanged();
 	}
 
+	// renames the entries of obj, shown the next time the list is opened
+	void setEntryName(const T& obj, const std::string& name)
+	{
+		for(auto it = mEntries.begin(); it != mEntries.end(); it++)
+		{
+			if(it->object == obj)
+				it->name = name;
+		}
+	}
+
+	inline void setSelectedChangedCallback(const std::function<void()>& callback) { mSelectedChangedCallback = callback; }
+
 private:
 	unsigned int getSelectedId()
 	{
@@ -304,6 +316,9 @@ private:
 
 	void onSelectedChanged()
 	{
+		if(mSelectedChangedCallback)
+			mSelectedChangedCallback();
+
 		if(mMultiSelect)
 		{
 			// display # selected
@@ -349,6 +364,7 @@ private:
 	ImageComponent mRightArrow;
 
 	std::vector<OptionListData> mEntries;
+	std::function<void()> mSelectedChangedCallback;
 };
 
 #endif // ES_CORE_COMPONENTS_OPTION_LIST_COMPONENT_H
@@ -0,0 +1,126 @@
+#include "utils/Arena.h"
+
+#include <new>
+#include <stdlib.h>
+
+namespace Utils
+{
+	// enough for anything that can be allocated with new
+	static const size_t ALIGNMENT = 16;
+
+	static inline size_t alignSize(size_t size)
+	{
+		return (size + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
+	}
+
+	static char* allocateBlock(size_t size)
+	{
+		char* block = (char*)malloc(size);
+		if (block == nullptr)
+			throw std::bad_alloc();
+
+		return block;
+	}
+
+	Arena::Arena(size_t blockSize) : mCurrent(nullptr), mEnd(nullptr), mBlockSize(alignSize(blockSize)), mReserved(0), mUsed(0)
+	{
+	}
+
+	Arena::~Arena()
+	{
+		clear();
+	}
+
+	void* Arena::allocate(size_t size)
+	{
+		size = alignSize(size < sizeof(FreeSlot) ? sizeof(FreeSlot) : size);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		FreeSlot*& freeList = getFreeList(size);
+		if (freeList != nullptr)
+		{
+			FreeSlot* slot = freeList;
+			freeList = slot->next;
+			mUsed += size;
+			return slot;
+		}
+
+		// big allocations get a block of their own instead of wasting the rest of the current one
+		if (size > mBlockSize / 4)
+		{
+			char* block = allocateBlock(size);
+			mBlocks.push_back(block);
+			mReserved += size;
+			mUsed     += size;
+			return block;
+		}
+
+		if ((size_t)(mEnd - mCurrent) < size)
+		{
+			mCurrent = allocateBlock(mBlockSize);
+			mEnd     = mCurrent + mBlockSize;
+			mBlocks.push_back(mCurrent);
+			mReserved += mBlockSize;
+		}
+
+		void* ptr = mCurrent;
+		mCurrent += size;
+		mUsed    += size;
+		return ptr;
+	}
+
+	void Arena::deallocate(void* ptr, size_t size)
+	{
+		if (ptr == nullptr)
+			return;
+
+		size = alignSize(size < sizeof(FreeSlot) ? sizeof(FreeSlot) : size);
+
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		FreeSlot*& freeList = getFreeList(size);
+		FreeSlot*  slot     = (FreeSlot*)ptr;
+		slot->next = freeList;
+		freeList   = slot;
+		mUsed     -= size;
+	}
+
+	void Arena::clear()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		for (char* block : mBlocks)
+			free(block);
+
+		mBlocks.clear();
+		mFreeLists.clear();
+		mCurrent  = nullptr;
+		mEnd      = nullptr;
+		mReserved = 0;
+		mUsed     = 0;
+	}
+
+	size_t Arena::getReservedBytes() const
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return mReserved;
+	}
+
+	size_t Arena::getUsedBytes() const
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		return mUsed;
+	}
+
+	Arena::FreeSlot*& Arena::getFreeList(size_t size)
+	{
+		for (auto& freeList : mFreeLists)
+			if (freeList.first == size)
+				return freeList.second;
+
+		mFreeLists.push_back(std::make_pair(size, (FreeSlot*)nullptr));
+		return mFreeLists.back().second;
+	}
+
+} // Utils::
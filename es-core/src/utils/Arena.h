@@ -0,0 +1,52 @@
+#pragma once
+#ifndef ES_CORE_UTILS_ARENA_H
+#define ES_CORE_UTILS_ARENA_H
+
+#include <mutex>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+namespace Utils
+{
+	// Hands out memory for many small objects that die together from large blocks. Nothing goes back to the
+	// system before clear() or the destructor, single allocations given back are only kept for reuse.
+	// The arena doesn't know about the objects, their destructors have to be run before it is cleared.
+	class Arena
+	{
+	public:
+		Arena(size_t blockSize = 64 * 1024);
+		~Arena();
+
+		void* allocate  (size_t size);
+		void  deallocate(void* ptr, size_t size);
+		void  clear     ();
+
+		size_t getReservedBytes() const;
+		size_t getUsedBytes    () const;
+
+	private:
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		struct FreeSlot
+		{
+			FreeSlot* next;
+		};
+
+		// there's only a handful of distinct sizes (one per class allocated here), a linear search is fine
+		FreeSlot*& getFreeList(size_t size);
+
+		mutable std::mutex                        mMutex;
+		std::vector<char*>                        mBlocks;
+		std::vector<std::pair<size_t, FreeSlot*>> mFreeLists;
+		char*                                     mCurrent;
+		char*                                     mEnd;
+		size_t                                    mBlockSize;
+		size_t                                    mReserved;
+		size_t                                    mUsed;
+	};
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_ARENA_H
@@ -4,8 +4,10 @@
 
 #include <sys/stat.h>
 #include <string.h>
-#include <map>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
 
 #if defined(_WIN32)
 // because windows...
@@ -15,6 +17,8 @@
 #define mkdir(x,y) _mkdir(x)
 #define snprintf _snprintf
 #define stat64 _stat64
+#define fstat64 _fstat64
+#define fileno _fileno
 #define unlink _unlink
 #define S_ISREG(x) (((x) & S_IFMT) == S_IFREG)
 #define S_ISDIR(x) (((x) & S_IFMT) == S_IFDIR)
@@ -29,10 +33,94 @@ namespace Utils
 {
 	namespace FileSystem
 	{
-		static std::recursive_mutex        mutex           = {};
-		static std::string                 homePath        = "";
-		static std::string                 exePath         = "";
-		static std::map<std::string, bool> pathExistsIndex = std::map<std::string, bool>();
+		enum PathType : unsigned char
+		{
+			PATH_MISSING,
+			PATH_FILE,
+			PATH_DIRECTORY,
+			PATH_OTHER
+
+		}; // PathType
+
+		// every shard has its own lock, so the loader threads hardly ever wait on each other
+		struct PathCacheShard
+		{
+			std::mutex                                mutex;
+			std::unordered_map<std::string, PathType> paths;
+
+		}; // PathCacheShard
+
+		static const size_t          PATH_CACHE_SHARDS = 64;
+
+		static std::recursive_mutex  mutex             = {};
+		static std::string           homePath          = "";
+		static std::string           exePath           = "";
+		static PathCacheShard        pathCache[PATH_CACHE_SHARDS];
+		static std::atomic<size_t>   pathCacheHits(0);
+		static std::atomic<size_t>   pathCacheMisses(0);
+
+//////////////////////////////////////////////////////////////////////////
+
+		static PathCacheShard& getPathCacheShard(const std::string& _path)
+		{
+			return pathCache[std::hash<std::string>()(_path) % PATH_CACHE_SHARDS];
+
+		} // getPathCacheShard
+
+//////////////////////////////////////////////////////////////////////////
+
+		static void setPathType(const std::string& _path, const PathType _type)
+		{
+			PathCacheShard&                    shard = getPathCacheShard(_path);
+			const std::unique_lock<std::mutex> lock(shard.mutex);
+
+			shard.paths[_path] = _type;
+
+		} // setPathType
+
+//////////////////////////////////////////////////////////////////////////
+
+		static PathType statPathType(const std::string& _path)
+		{
+			const std::string path = getGenericPath(_path);
+			struct stat64     info;
+
+			// check if stat64 succeeded
+			if(stat64(path.c_str(), &info) != 0)
+				return PATH_MISSING;
+
+			return S_ISREG(info.st_mode) ? PATH_FILE : (S_ISDIR(info.st_mode) ? PATH_DIRECTORY : PATH_OTHER);
+
+		} // statPathType
+
+//////////////////////////////////////////////////////////////////////////
+
+		static PathType getPathType(const std::string& _path)
+		{
+			PathCacheShard& shard = getPathCacheShard(_path);
+
+			{
+				const std::unique_lock<std::mutex> lock(shard.mutex);
+				const auto                         it = shard.paths.find(_path);
+
+				if(it != shard.paths.cend())
+				{
+					pathCacheHits.fetch_add(1, std::memory_order_relaxed);
+					return it->second;
+				}
+			}
+
+			pathCacheMisses.fetch_add(1, std::memory_order_relaxed);
+
+			// stat without holding the lock, a thread missing the same path meanwhile just finds the same
+			const PathType type = statPathType(_path);
+
+			const std::unique_lock<std::mutex> lock(shard.mutex);
+			shard.paths.emplace(_path, type);
+
+			return type;
+
+		} // getPathType
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -125,6 +213,90 @@ namespace Utils
 
 		} // getDirContent
 
+//////////////////////////////////////////////////////////////////////////
+
+		entryList getDirEntries(const std::string& _path)
+		{
+			const std::string path = getGenericPath(_path);
+			entryList         entries;
+
+#if defined(_WIN32)
+			WIN32_FIND_DATAW findData;
+			const std::string wildcard = path + "/*";
+			const HANDLE      hFind    = FindFirstFileW(std::wstring(wildcard.begin(), wildcard.end()).c_str(), &findData);
+
+			if(hFind != INVALID_HANDLE_VALUE)
+			{
+				// loop over all files in the directory, the attributes come along for free
+				do
+				{
+					const std::string name = convertFromWideString(findData.cFileName);
+
+					// ignore "." and ".."
+					if((name != ".") && (name != ".."))
+					{
+						DirEntry entry;
+						entry.path        = getGenericPath(path + "/" + name);
+						entry.isDirectory = (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+						entry.isHidden    = (name[0] == '.') || (findData.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN) != 0;
+						entries.push_back(entry);
+
+						setPathType(entry.path, entry.isDirectory ? PATH_DIRECTORY : PATH_FILE);
+					}
+				}
+				while(FindNextFileW(hFind, &findData));
+
+				FindClose(hFind);
+			}
+#else // _WIN32
+			DIR* dir = opendir(path.c_str());
+
+			if(dir != NULL)
+			{
+				struct dirent* ent;
+
+				// loop over all files in the directory
+				while((ent = readdir(dir)) != NULL)
+				{
+					const char* name = ent->d_name;
+
+					// ignore "." and ".."
+					if((name[0] == '.') && ((name[1] == '\0') || ((name[1] == '.') && (name[2] == '\0'))))
+						continue;
+
+					DirEntry entry;
+					entry.path     = getGenericPath(path + "/" + name);
+					entry.isHidden = (name[0] == '.');
+
+					// d_type saves a stat per entry, only symlinks and filesystems that don't fill it in need one,
+					// the listing also answers later exists() calls for the entry
+					if(ent->d_type == DT_DIR)
+					{
+						entry.isDirectory = true;
+						setPathType(entry.path, PATH_DIRECTORY);
+					}
+					else if(ent->d_type == DT_REG)
+					{
+						entry.isDirectory = false;
+						setPathType(entry.path, PATH_FILE);
+					}
+					else
+						entry.isDirectory = isDirectory(entry.path);
+
+					entries.push_back(entry);
+				}
+
+				closedir(dir);
+			}
+#endif // !_WIN32
+
+			// same order as getDirContent
+			std::sort(entries.begin(), entries.end(), [](const DirEntry& _a, const DirEntry& _b) { return _a.path < _b.path; });
+
+			return entries;
+
+		} // getDirEntries
+
 //////////////////////////////////////////////////////////////////////////
 
 		stringList getPathList(const std::string& _path)
@@ -598,8 +770,7 @@ namespace Utils
 
 		bool removeFile(const std::string& _path)
 		{
-			const std::unique_lock<std::recursive_mutex> lock(mutex);
-			const std::string                            path = getGenericPath(_path);
+			const std::string path = getGenericPath(_path);
 
 			// don't remove if it doesn't exists
 			if(!exists(path))
@@ -609,7 +780,10 @@ namespace Utils
 			
 			// if removed, let's remove it from the index
 			if (removed)
-				pathExistsIndex[_path] = false;
+			{
+				setPathType(_path, PATH_MISSING);
+				setPathType(path, PATH_MISSING);
+			}
 
 			// try to remove file
 			return removed;
@@ -629,7 +803,8 @@ namespace Utils
 			// try to create directory
 			if(mkdir(path.c_str(), 0755) == 0)
 			{
-				pathExistsIndex[_path] = true;
+				setPathType(_path, PATH_DIRECTORY);
+				setPathType(path, PATH_DIRECTORY);
 				return true;
 			}
 
@@ -643,7 +818,10 @@ namespace Utils
 			// try to create directory again now that the parent should exist
 			bool created = (mkdir(path.c_str(), 0755) == 0);
 			if(created)
-				pathExistsIndex[_path] = true;
+			{
+				setPathType(_path, PATH_DIRECTORY);
+				setPathType(path, PATH_DIRECTORY);
+			}
 
 			return created;
 
@@ -653,19 +831,61 @@ namespace Utils
 
 		bool exists(const std::string& _path)
 		{
-			const std::unique_lock<std::recursive_mutex> lock(mutex);
+			return (getPathType(_path) != PATH_MISSING);
+
+		} // exists
+
+//////////////////////////////////////////////////////////////////////////
 
-			if(pathExistsIndex.find(_path) == pathExistsIndex.cend())
+		void forgetExists(const std::string& _path, const bool _recursive)
+		{
+			// drops the memoized state of a path known to have changed outside of ES, and with _recursive of everything below it
 			{
-				const std::string path = getGenericPath(_path);
-				struct stat64 info;
-				// check if stat64 succeeded
-				pathExistsIndex[_path] = (stat64(path.c_str(), &info) == 0);
+				PathCacheShard&                    shard = getPathCacheShard(_path);
+				const std::unique_lock<std::mutex> lock(shard.mutex);
+
+				shard.paths.erase(_path);
 			}
 
-			return pathExistsIndex.at(_path);
+			if(!_recursive)
+				return;
 
-		} // exists
+			const std::string prefix = getGenericPath(_path) + "/";
+
+			for(size_t i = 0; i < PATH_CACHE_SHARDS; ++i)
+			{
+				PathCacheShard&                    shard = pathCache[i];
+				const std::unique_lock<std::mutex> lock(shard.mutex);
+
+				for(auto it = shard.paths.begin(); it != shard.paths.end(); )
+				{
+					if(it->first.compare(0, prefix.size(), prefix) == 0)
+						it = shard.paths.erase(it);
+					else
+						++it;
+				}
+			}
+
+		} // forgetExists
+
+//////////////////////////////////////////////////////////////////////////
+
+		CacheStats getCacheStats()
+		{
+			CacheStats stats;
+			stats.entries = 0;
+			stats.hits    = pathCacheHits.load(std::memory_order_relaxed);
+			stats.misses  = pathCacheMisses.load(std::memory_order_relaxed);
+
+			for(size_t i = 0; i < PATH_CACHE_SHARDS; ++i)
+			{
+				const std::unique_lock<std::mutex> lock(pathCache[i].mutex);
+				stats.entries += pathCache[i].paths.size();
+			}
+
+			return stats;
+
+		} // getCacheStats
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -685,15 +905,12 @@ namespace Utils
 
 		bool isRegularFile(const std::string& _path)
 		{
-			const std::string path = getGenericPath(_path);
-			struct stat64     info;
+			// always asked again, paths like music folders, screensaver media and custom collections change while
+			// ES is running; what is found keeps exists() up to date as well
+			const PathType type = statPathType(_path);
+			setPathType(_path, type);
 
-			// check if stat64 succeeded
-			if(stat64(path.c_str(), &info) != 0)
-				return false;
-
-			// check for S_IFREG attribute
-			return (S_ISREG(info.st_mode));
+			return (type == PATH_FILE);
 
 		} // isRegularFile
 
@@ -701,15 +918,11 @@ namespace Utils
 
 		bool isDirectory(const std::string& _path)
 		{
-			const std::string path = getGenericPath(_path);
-			struct stat64     info;
-
-			// check if stat64 succeeded
-			if(stat64(path.c_str(), &info) != 0)
-				return false;
+			// always asked again, see isRegularFile()
+			const PathType type = statPathType(_path);
+			setPathType(_path, type);
 
-			// check for S_IFDIR attribute
-			return (S_ISDIR(info.st_mode));
+			return (type == PATH_DIRECTORY);
 
 		} // isDirectory
 
@@ -762,6 +975,66 @@ namespace Utils
 
 		} // isHidden
 
+//////////////////////////////////////////////////////////////////////////
+
+		time_t getModificationTime(const std::string& _path)
+		{
+			const std::string path = getGenericPath(_path);
+			struct stat64     info;
+
+			// check if stat64 succeeded
+			if(stat64(path.c_str(), &info) != 0)
+				return 0;
+
+			return info.st_mtime;
+
+		} // getModificationTime
+
+//////////////////////////////////////////////////////////////////////////
+
+		static FileStamp getFileStamp(const struct stat64& info)
+		{
+			FileStamp stamp;
+
+#if defined(_WIN32)
+			stamp.modTime = (int64_t)info.st_mtime * 1000000000;
+#elif defined(__APPLE__)
+			stamp.modTime = (int64_t)info.st_mtimespec.tv_sec * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+			stamp.modTime = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+			stamp.size  = (int64_t)info.st_size;
+			stamp.inode = (uint64_t)info.st_ino;
+
+			return stamp;
+
+		} // getFileStamp
+
+		FileStamp getFileStamp(const std::string& _path)
+		{
+			const std::string path = getGenericPath(_path);
+			struct stat64     info;
+
+			// check if stat64 succeeded
+			if(stat64(path.c_str(), &info) != 0)
+				return FileStamp();
+
+			return getFileStamp(info);
+
+		} // getFileStamp
+
+		FileStamp getFileStamp(FILE* _file)
+		{
+			struct stat64 info;
+
+			// check if fstat64 succeeded
+			if(fstat64(fileno(_file), &info) != 0)
+				return FileStamp();
+
+			return getFileStamp(info);
+
+		} // getFileStamp
+
 //////////////////////////////////////////////////////////////////////////
 
 #if !defined(_WIN32)
@@ -3,7 +3,11 @@
 #define ES_CORE_UTILS_FILE_SYSTEM_UTIL_H
 
 #include <list>
+#include <stdint.h>
+#include <stdio.h>
 #include <string>
+#include <time.h>
+#include <vector>
 
 namespace Utils
 {
@@ -11,7 +15,39 @@ namespace Utils
 	{
 		typedef std::list<std::string> stringList;
 
+		struct DirEntry
+		{
+			std::string path;
+			bool        isDirectory;
+			bool        isHidden;
+		};
+		typedef std::vector<DirEntry> entryList;
+
+		// exists() is answered from a cache that getDirEntries(), isRegularFile() and isDirectory() fill as well,
+		// paths changed outside of ES have to be dropped with forgetExists()
+		struct CacheStats
+		{
+			size_t entries;
+			size_t hits;
+			size_t misses;
+		};
+
+		// Tells two versions of a file apart where a modification time in seconds can't, all 0 if the file is missing.
+		// Windows has neither nanoseconds nor inodes, there it's only as good as the time in seconds and the size.
+		struct FileStamp
+		{
+			FileStamp() : modTime(0), size(0), inode(0) {}
+
+			inline bool operator==(const FileStamp& _other) const { return (modTime == _other.modTime) && (size == _other.size) && (inode == _other.inode); }
+			inline bool operator!=(const FileStamp& _other) const { return !(*this == _other); }
+
+			int64_t  modTime; // nanoseconds
+			int64_t  size;
+			uint64_t inode;
+		};
+
 		stringList  getDirContent      (const std::string& _path, const bool _recursive = false);
+		entryList   getDirEntries      (const std::string& _path);
 		stringList  getPathList        (const std::string& _path);
 		void        setHomePath        (const std::string& _path);
 		std::string getHomePath        ();
@@ -34,11 +70,16 @@ namespace Utils
 		bool        removeFile         (const std::string& _path);
 		bool        createDirectory    (const std::string& _path);
 		bool        exists             (const std::string& _path);
+		void        forgetExists       (const std::string& _path, const bool _recursive = false);
+		CacheStats  getCacheStats      ();
 		bool        isAbsolute         (const std::string& _path);
 		bool        isRegularFile      (const std::string& _path);
 		bool        isDirectory        (const std::string& _path);
 		bool        isSymlink          (const std::string& _path);
 		bool        isHidden           (const std::string& _path);
+		time_t      getModificationTime(const std::string& _path);
+		FileStamp   getFileStamp       (const std::string& _path);
+		FileStamp   getFileStamp       (FILE* _file);
 #if !defined(_WIN32)
 		bool        isExecutable       (const std::string& _path);
 #endif // !_WIN32
@@ -0,0 +1,64 @@
+#include "utils/StringPoolUtil.h"
+
+#include <mutex>
+#include <unordered_set>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Utils
+{
+	namespace StringPool
+	{
+		// sharded like the path cache, the loader threads intern while they create FileData
+		struct Shard
+		{
+			Shard() : bytes(0) {}
+
+			std::mutex                      mutex;
+			std::unordered_set<std::string> strings;
+			size_t                          bytes;
+
+		}; // Shard
+
+		static const size_t SHARDS = 16;
+
+		static Shard shards[SHARDS];
+
+//////////////////////////////////////////////////////////////////////////
+
+		const std::string& intern(const std::string& _string)
+		{
+			Shard&                             shard = shards[std::hash<std::string>()(_string) % SHARDS];
+			const std::unique_lock<std::mutex> lock(shard.mutex);
+
+			// the set is node based, so the string never moves once it's in
+			const auto inserted = shard.strings.insert(_string);
+			if(inserted.second)
+				shard.bytes += _string.capacity() + sizeof(std::string);
+
+			return *inserted.first;
+
+		} // intern
+
+//////////////////////////////////////////////////////////////////////////
+
+		Stats getStats()
+		{
+			Stats stats;
+			stats.strings = 0;
+			stats.bytes   = 0;
+
+			for(size_t i = 0; i < SHARDS; ++i)
+			{
+				const std::unique_lock<std::mutex> lock(shards[i].mutex);
+				stats.strings += shards[i].strings.size();
+				stats.bytes   += shards[i].bytes;
+			}
+
+			return stats;
+
+		} // getStats
+
+	} // StringPool::
+
+} // Utils::
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef ES_CORE_UTILS_STRING_POOL_UTIL_H
+#define ES_CORE_UTILS_STRING_POOL_UTIL_H
+
+#include <stddef.h>
+#include <string>
+
+namespace Utils
+{
+	namespace StringPool
+	{
+		// Keeps one copy of strings that many objects share (directory prefixes, system names, ...).
+		// Interned strings are never freed and keep their address, so callers can hold on to the reference.
+
+		struct Stats
+		{
+			size_t strings;
+			size_t bytes;
+		};
+
+		const std::string& intern  (const std::string& _string);
+		Stats              getStats();
+
+	} // StringPool::
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_STRING_POOL_UTIL_H
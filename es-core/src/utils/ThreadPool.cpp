@@ -1,93 +1,266 @@
 #include "ThreadPool.h"
 
+#include "utils/TraceUtil.h"
+#include "Log.h"
+
 #if WIN32
 #include <Windows.h>
 #endif
 
 namespace Utils
 {
-	ThreadPool::ThreadPool() : mRunning(true), mWaiting(false), mNumWork(0)
+	static const size_t NO_WORKER = (size_t)-1;
+
+	// the pool and queue index of the worker running on the current thread, if any
+	static thread_local ThreadPool* tCurrentPool   = nullptr;
+	static thread_local size_t      tCurrentWorker = NO_WORKER;
+
+	static std::mutex sSharedMutex;
+	ThreadPool*       ThreadPool::sShared            = nullptr;
+	size_t            ThreadPool::sSharedThreadCount = 0;
+
+	ThreadPool::ThreadPool(size_t numThreads) : mRunning(true), mNextQueue(0), mNumUnfinished(0), mNumHelpers(0)
 	{
-		size_t num_threads = std::thread::hardware_concurrency() - 1;
+		for (int priority = PRIORITY_HIGH; priority < PRIORITY_COUNT; priority++)
+			mNumPending[priority] = 0;
 
-		auto doWork = [&](size_t id)
+		if (numThreads == 0)
 		{
-#if WIN32
-			auto mask = (static_cast<DWORD_PTR>(1) << id);
-			SetThreadAffinityMask(GetCurrentThread(), mask);
-#endif
+			const size_t cores = std::thread::hardware_concurrency();
+			numThreads = (cores > 2) ? (cores - 1) : 1;
+		}
+
+		mQueues.reserve(numThreads);
+		for (size_t i = 0; i < numThreads; i++)
+			mQueues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+
+		mThreads.reserve(numThreads);
+		for (size_t i = 0; i < numThreads; i++)
+			mThreads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		// let everything that was queued finish, futures handed out have to be satisfied
+		wait();
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mRunning = false;
+		}
+		mWorkCondition.notify_all();
+
+		for (std::thread& t : mThreads)
+			if (t.joinable())
+				t.join();
+	}
+
+	ThreadPool* ThreadPool::getShared()
+	{
+		std::unique_lock<std::mutex> lock(sSharedMutex);
+
+		if (sShared == nullptr)
+			sShared = new ThreadPool(sSharedThreadCount);
 
-			while (mRunning)
+		return sShared;
+	}
+
+	void ThreadPool::setSharedThreadCount(size_t numThreads)
+	{
+		std::unique_lock<std::mutex> lock(sSharedMutex);
+		sSharedThreadCount = numThreads;
+	}
+
+	void ThreadPool::deinitShared()
+	{
+		std::unique_lock<std::mutex> lock(sSharedMutex);
+
+		delete sShared;
+		sShared = nullptr;
+	}
+
+	void ThreadPool::queueWorkItem(work_function work, Priority priority)
+	{
+		queueTask([work]
+		{
+			try
 			{
-				_mutex.lock();
-				if (!mWorkQueue.empty())
-				{
-					auto work = mWorkQueue.front();
-					mWorkQueue.pop();
-					_mutex.unlock();
+				work();
+			}
+			catch (std::exception& e)
+			{
+				LOG(LogError) << "ThreadPool work item failed: " << e.what();
+			}
+			catch (...)
+			{
+				LOG(LogError) << "ThreadPool work item failed with an unknown exception";
+			}
+		}, priority);
+	}
 
-					try
-					{
-						work();
-					}
-					catch (...) {}
+	void ThreadPool::queueTask(work_function task, Priority priority)
+	{
+		// work queued from one of our workers stays local to it, everything else is spread round robin
+		const size_t index = (tCurrentPool == this) ? tCurrentWorker : (mNextQueue++ % mQueues.size());
 
-					mNumWork--;
-				}
-				else
+		mNumUnfinished++;
+
+		// counted before it can be taken, a thread taking it right away must not drop the count below zero
+		bool helping;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mNumPending[priority]++;
+			helping = (mNumHelpers > 0);
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mQueues[index]->mutex);
+			mQueues[index]->tasks[priority].push_back(task);
+		}
+
+		// a thread helping out in wait() may not take it, waking just that one would leave it queued
+		if (helping)
+			mWorkCondition.notify_all();
+		else
+			mWorkCondition.notify_one();
+	}
+
+	bool ThreadPool::takeTask(size_t self, Priority maxPriority, work_function& task, Priority& priority)
+	{
+		for (priority = PRIORITY_HIGH; priority <= maxPriority; priority = (Priority)(priority + 1))
+		{
+			// newest work of our own first, it is the most likely to still be in the cache
+			if (self != NO_WORKER)
+			{
+				WorkerQueue& queue = *mQueues[self];
+				std::unique_lock<std::mutex> lock(queue.mutex);
+
+				if (!queue.tasks[priority].empty())
 				{
-					_mutex.unlock();
+					task = std::move(queue.tasks[priority].back());
+					queue.tasks[priority].pop_back();
+					return true;
+				}
+			}
 
-					// Extra code : Exit finished threads
-					if (mWaiting)
-						return;
+			// then steal the oldest work of the others
+			const size_t start = (self != NO_WORKER) ? self + 1 : 0;
+			for (size_t i = 0; i < mQueues.size(); i++)
+			{
+				const size_t victim = (start + i) % mQueues.size();
+				if (victim == self)
+					continue;
+
+				WorkerQueue& queue = *mQueues[victim];
+				std::unique_lock<std::mutex> lock(queue.mutex);
 
-					std::this_thread::yield();
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				if (!queue.tasks[priority].empty())
+				{
+					task = std::move(queue.tasks[priority].front());
+					queue.tasks[priority].pop_front();
+					return true;
 				}
 			}
-		};
+		}
+
+		return false;
+	}
 
-		mThreads.reserve(num_threads);
+	bool ThreadPool::runPendingTask(Priority maxPriority)
+	{
+		work_function task;
+		Priority      priority;
+		if (!takeTask((tCurrentPool == this) ? tCurrentWorker : NO_WORKER, maxPriority, task, priority))
+			return false;
+
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mNumPending[priority]--;
+		}
+
+		task();
+		finishTask();
 
-		for (size_t i = 0; i < num_threads; i++)
-			mThreads.push_back(std::thread(doWork, i));
+		return true;
 	}
 
-	ThreadPool::~ThreadPool()
+	size_t ThreadPool::countPending(Priority maxPriority) const
 	{
-		mRunning = false;
+		size_t count = 0;
+		for (int priority = PRIORITY_HIGH; priority <= maxPriority; priority++)
+			count += mNumPending[priority];
 
-		for (std::thread& t : mThreads)
-			if (t.joinable())
-				t.join();
+		return count;
+	}
+
+	void ThreadPool::finishTask()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		if (--mNumUnfinished == 0)
+			mDoneCondition.notify_all();
+
+		// threads helping out in wait() also wait for results, not only for new work
+		if (mNumHelpers > 0)
+			mWorkCondition.notify_all();
 	}
 
-	void ThreadPool::queueWorkItem(work_function work)
+	void ThreadPool::helpUntil(const std::function<bool()>& isDone, Priority maxPriority)
 	{
-		_mutex.lock();
-		mWorkQueue.push(work);
-		mNumWork++;
-		_mutex.unlock();
+		while (!isDone())
+		{
+			if (runPendingTask(maxPriority))
+				continue;
+
+			// less urgent work is left to the workers
+			std::unique_lock<std::mutex> lock(mMutex);
+			mNumHelpers++;
+			mWorkCondition.wait(lock, [this, &isDone, maxPriority] { return (countPending(maxPriority) > 0) || isDone(); });
+			mNumHelpers--;
+		}
+	}
+
+	void ThreadPool::workerLoop(size_t id)
+	{
+#if WIN32
+		auto mask = (static_cast<DWORD_PTR>(1) << id);
+		SetThreadAffinityMask(GetCurrentThread(), mask);
+#endif
+
+		tCurrentPool   = this;
+		tCurrentWorker = id;
+
+		Utils::Trace::setThreadName("worker " + std::to_string(id));
+
+		while (true)
+		{
+			if (runPendingTask())
+				continue;
+
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkCondition.wait(lock, [this] { return (countPending(PRIORITY_LOW) > 0) || !mRunning; });
+
+			if (!mRunning && (countPending(PRIORITY_LOW) == 0))
+				return;
+		}
 	}
 
 	void ThreadPool::wait()
 	{
-		mWaiting = true;
-		while (mNumWork.load() > 0)
-			std::this_thread::yield();
+		helpUntil([this] { return mNumUnfinished.load() == 0; }, PRIORITY_LOW);
 	}
 
 	void ThreadPool::wait(work_function work, int delay)
 	{
-		mWaiting = true;
+		std::unique_lock<std::mutex> lock(mMutex);
 
-		while (mNumWork.load() > 0)
+		while (mNumUnfinished.load() > 0)
 		{
+			lock.unlock();
 			work();
+			lock.lock();
 
-			std::this_thread::yield();
-			std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+			mDoneCondition.wait_for(lock, std::chrono::milliseconds(delay), [this] { return mNumUnfinished.load() == 0; });
 		}
 	}
-}
\ No newline at end of file
+}
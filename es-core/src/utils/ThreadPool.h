@@ -1,32 +1,105 @@
 #pragma once
+#ifndef ES_CORE_UTILS_THREAD_POOL_H
+#define ES_CORE_UTILS_THREAD_POOL_H
 
 #include <thread>
 #include <mutex>
-#include <queue>
+#include <condition_variable>
+#include <deque>
 #include <atomic>
 #include <functional>
+#include <future>
+#include <memory>
+#include <vector>
 
 namespace Utils
 {
+	// Work-stealing executor: every worker owns a queue per priority, pops its own work LIFO and steals
+	// FIFO from the others when it runs dry. Idle workers sleep on a condition variable.
 	class ThreadPool
 	{
 	public:
 		typedef std::function<void(void)> work_function;
 
-		ThreadPool();
+		enum Priority
+		{
+			PRIORITY_HIGH,
+			PRIORITY_NORMAL,
+			PRIORITY_LOW,
+
+			PRIORITY_COUNT
+		};
+
+		ThreadPool(size_t numThreads = 0); // 0 = one thread less than there are cores
 		~ThreadPool();
 
-		void queueWorkItem(work_function work);
+		// Pool shared by everything that doesn't need its own, created on first use.
+		static ThreadPool* getShared();
+		static void        setSharedThreadCount(size_t numThreads); // only has an effect before the first getShared()
+		static void        deinitShared();
+
+		// Exceptions thrown by the work item are logged and dropped.
+		void queueWorkItem(work_function work, Priority priority = PRIORITY_NORMAL);
+
+		// Exceptions thrown by the work item are passed on through the future.
+		template<typename F>
+		std::future<typename std::result_of<F()>::type> submit(F work, Priority priority = PRIORITY_NORMAL)
+		{
+			typedef typename std::result_of<F()>::type result_type;
+
+			std::shared_ptr<std::packaged_task<result_type()>> task = std::make_shared<std::packaged_task<result_type()>>(work);
+			std::future<result_type> result = task->get_future();
+			queueTask([task] { (*task)(); }, priority);
+			return result;
+		}
+
+		// Waits for all queued work, the calling thread helps out in the meantime. Not to be called from a work item.
 		void wait();
+		// Waits for all queued work, calling work every delay milliseconds in the meantime (i.e. to render progress).
 		void wait(work_function work, int delay = 50);
 
+		// Waits for a single result, running queued work on the calling thread until it is available.
+		// Safe to use from inside a work item, which then never blocks a worker on its own sub tasks.
+		// Only work of priority (the one the result was submitted with) or higher is run, so waiting
+		// for something urgent doesn't get stuck in background work.
+		template<typename T>
+		void wait(std::future<T>& result, Priority priority = PRIORITY_NORMAL)
+		{
+			helpUntil([&result] { return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }, priority);
+		}
+
+		inline size_t getThreadCount() const { return mThreads.size(); }
+
 	private:
+		struct WorkerQueue
+		{
+			std::mutex              mutex;
+			std::deque<work_function> tasks[PRIORITY_COUNT];
+		};
+
+		void queueTask(work_function task, Priority priority);
+		bool takeTask(size_t self, Priority maxPriority, work_function& task, Priority& priority);
+		bool runPendingTask(Priority maxPriority = PRIORITY_LOW);
+		size_t countPending(Priority maxPriority) const;
+		void finishTask();
+		void helpUntil(const std::function<bool()>& isDone, Priority maxPriority);
+		void workerLoop(size_t id);
+
 		bool mRunning;
-		bool mWaiting;
-		std::queue<work_function> mWorkQueue;
-		std::atomic<size_t> mNumWork;
-		std::mutex _mutex;
+		std::vector<std::unique_ptr<WorkerQueue>> mQueues;
 		std::vector<std::thread> mThreads;
+		std::atomic<size_t> mNextQueue;
+		std::atomic<size_t> mNumPending[PRIORITY_COUNT]; // queued, not yet taken by a thread
+		std::atomic<size_t> mNumUnfinished; // queued or running
+		size_t mNumHelpers;
+
+		std::mutex mMutex;
+		std::condition_variable mWorkCondition;
+		std::condition_variable mDoneCondition;
 
+		static ThreadPool* sShared;
+		static size_t      sSharedThreadCount;
 	};
-}
\ No newline at end of file
+}
+
+#endif // ES_CORE_UTILS_THREAD_POOL_H
@@ -0,0 +1,197 @@
+#include "utils/TraceUtil.h"
+
+#include "Log.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////
+
+namespace Utils
+{
+	namespace Trace
+	{
+		struct Event
+		{
+			const char* name;
+			std::string detail;
+			int64_t     begin;
+			int64_t     end;
+
+		}; // Event
+
+		// spans are only appended by their own thread, the mutex is just taken against stop()
+		struct ThreadEvents
+		{
+			std::mutex         mutex;
+			std::vector<Event> events;
+			std::string        name;
+			unsigned int       id;
+
+		}; // ThreadEvents
+
+		static std::atomic<bool>                     enabled(false);
+		static std::mutex                            mutex;
+		static std::vector<ThreadEvents*>            threads;
+		static std::string                           path;
+		static std::chrono::steady_clock::time_point startTime;
+
+		static thread_local ThreadEvents* currentThread = nullptr;
+
+//////////////////////////////////////////////////////////////////////////
+
+		static ThreadEvents* getThreadEvents(void)
+		{
+			if(!currentThread)
+			{
+				const std::unique_lock<std::mutex> lock(mutex);
+
+				// kept until exit, a thread can still be tracing while the file gets written
+				currentThread     = new ThreadEvents;
+				currentThread->id = (unsigned int)threads.size() + 1;
+				threads.push_back(currentThread);
+			}
+
+			return currentThread;
+
+		} // getThreadEvents
+
+//////////////////////////////////////////////////////////////////////////
+
+		static std::string escape(const std::string& _string)
+		{
+			std::string escaped;
+			escaped.reserve(_string.size());
+
+			for(const char c : _string)
+			{
+				switch(c)
+				{
+					case '"':  { escaped += "\\\""; } break;
+					case '\\': { escaped += "\\\\"; } break;
+					case '\n': { escaped += "\\n";  } break;
+					case '\t': { escaped += "\\t";  } break;
+					default:
+					{
+						if((unsigned char)c >= 0x20)
+							escaped += c;
+					}
+					break;
+				}
+			}
+
+			return escaped;
+
+		} // escape
+
+//////////////////////////////////////////////////////////////////////////
+
+		void start(const std::string& _path)
+		{
+			const std::unique_lock<std::mutex> lock(mutex);
+
+			path      = _path;
+			startTime = std::chrono::steady_clock::now();
+			enabled   = true;
+
+		} // start
+
+//////////////////////////////////////////////////////////////////////////
+
+		void stop(void)
+		{
+			if(!enabled.exchange(false))
+				return;
+
+			const std::unique_lock<std::mutex> lock(mutex);
+
+			std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+			if(!file.is_open())
+			{
+				LOG(LogError) << "Could not write trace to \"" << path << "\"";
+				return;
+			}
+
+			size_t count = 0;
+			bool   first = true;
+
+			file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+			for(ThreadEvents* thread : threads)
+			{
+				const std::unique_lock<std::mutex> threadLock(thread->mutex);
+
+				if(thread->events.empty())
+					continue;
+
+				file << (first ? "\n" : ",\n");
+				file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id
+				     << ",\"args\":{\"name\":\"" << escape(thread->name.empty() ? "thread " + std::to_string(thread->id) : thread->name) << "\"}}";
+				first = false;
+
+				for(const Event& event : thread->events)
+				{
+					file << ",\n{\"name\":\"" << escape(event.name) << "\",\"cat\":\"es\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+					     << ",\"ts\":" << event.begin << ",\"dur\":" << (event.end - event.begin);
+
+					if(!event.detail.empty())
+						file << ",\"args\":{\"detail\":\"" << escape(event.detail) << "\"}";
+
+					file << "}";
+				}
+
+				count += thread->events.size();
+				thread->events.clear();
+				thread->events.shrink_to_fit();
+			}
+
+			file << "\n]}\n";
+			file.close();
+
+			LOG(LogInfo) << "Wrote " << count << " trace events to \"" << path << "\"";
+
+		} // stop
+
+//////////////////////////////////////////////////////////////////////////
+
+		bool isEnabled(void)
+		{
+			return enabled.load(std::memory_order_relaxed);
+
+		} // isEnabled
+
+//////////////////////////////////////////////////////////////////////////
+
+		void setThreadName(const std::string& _name)
+		{
+			ThreadEvents*                      thread = getThreadEvents();
+			const std::unique_lock<std::mutex> lock(thread->mutex);
+
+			thread->name = _name;
+
+		} // setThreadName
+
+//////////////////////////////////////////////////////////////////////////
+
+		int64_t _now(void)
+		{
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+
+		} // _now
+
+//////////////////////////////////////////////////////////////////////////
+
+		void _record(const char* _name, const std::string& _detail, const int64_t _begin, const int64_t _end)
+		{
+			ThreadEvents*                      thread = getThreadEvents();
+			const std::unique_lock<std::mutex> lock(thread->mutex);
+
+			thread->events.push_back({ _name, _detail, _begin, _end });
+
+		} // _record
+
+	} // Trace::
+
+} // Utils::
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef ES_CORE_UTILS_TRACE_UTIL_H
+#define ES_CORE_UTILS_TRACE_UTIL_H
+
+#include <stdint.h>
+#include <string>
+
+namespace Utils
+{
+	namespace Trace
+	{
+		// Records timed spans per thread between start() and stop(), stop() writes them as a Chrome
+		// trace_event JSON file (load it in chrome://tracing or https://ui.perfetto.dev).
+		// Always compiled in, a span costs a single flag check while tracing is off.
+
+		void start        (const std::string& _path);
+		void stop         (void);
+		bool isEnabled    (void);
+		void setThreadName(const std::string& _name);
+
+//////////////////////////////////////////////////////////////////////////
+
+		int64_t _now   (void);
+		void    _record(const char* _name, const std::string& _detail, const int64_t _begin, const int64_t _end);
+
+//////////////////////////////////////////////////////////////////////////
+
+		class Scope
+		{
+		public:
+
+			 Scope(const char* _name, const std::string& _detail = "") : mName(isEnabled() ? _name : nullptr), mBegin(0) { if(mName) { mDetail = _detail; mBegin = _now(); } }
+			~Scope(void)                                                                                                   { if(mName) _record(mName, mDetail, mBegin, _now()); }
+
+		private:
+
+			const char* mName;
+			std::string mDetail;
+			int64_t     mBegin;
+
+		}; // Scope
+
+	}; // Trace::
+
+} // Utils::
+
+#define _traceUnique(_name, _line) _name ## _line
+#define _traceUniqueScope(_line)   _traceUnique(traceScope, _line)
+#define __traceUniqueScope         _traceUniqueScope(__LINE__)
+
+#define TraceScope(_name)                  const Utils::Trace::Scope __traceUniqueScope(_name)
+#define TraceScopeDetail(_name, _detail)   const Utils::Trace::Scope __traceUniqueScope(_name, _detail)
+
+#endif // ES_CORE_UTILS_TRACE_UTIL_H